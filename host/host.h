@@ -0,0 +1,118 @@
+/*
+Harness side of the host SDK: the clock, event delivery and the
+counters that pebble_host.c keeps while the app runs.
+*/
+
+#ifndef HOST_HOST_H
+#define HOST_HOST_H
+
+#include <pebble.h>
+
+typedef enum {
+	HOST_OBJ_WINDOW,
+	HOST_OBJ_LAYER,
+	HOST_OBJ_TEXT_LAYER,
+	HOST_OBJ_BITMAP_LAYER,
+	HOST_OBJ_BITMAP,
+	HOST_OBJ_FONT,
+	HOST_OBJ_COUNT,
+} HostObjectKind;
+
+typedef struct {
+	// Every event handed to the app wakes up the watch.
+	uint32_t wakeups;
+	uint32_t ticks;
+	uint32_t timers_fired;
+	uint32_t bluetooth_events;
+	uint32_t battery_events;
+	uint32_t inbox_messages;
+	uint32_t window_events;
+
+	// Redraw work, done once per event like the firmware does.
+	uint32_t frames;
+	uint32_t layer_redraws;
+	uint64_t redraw_area; // pixels
+	uint32_t text_updates;
+
+	uint32_t vibes;
+	uint32_t vibe_ms;
+
+	uint32_t outbox_messages;
+	uint64_t outbox_bytes;
+	uint64_t inbox_bytes;
+	uint32_t inbox_dropped;
+	uint32_t sync_errors; // AppSync error callbacks, e.g. a message too big to merge
+
+	uint32_t persist_writes;
+
+	// Leak checks
+	uint32_t sync_reinits;   // app_sync_init on an AppSync that's still active
+	uint32_t sync_inits;
+	uint32_t sync_deinits;
+	uint32_t stacked_timers; // Timer registered while the same callback/data was pending
+	uint32_t timers_pending;
+	uint32_t timers_peak;
+	uint32_t bitmap_creates;
+	uint32_t bitmap_churn;   // Bitmap destroyed and recreated from the same resource in one event
+
+	uint32_t live[HOST_OBJ_COUNT];
+	uint32_t peak[HOST_OBJ_COUNT];
+} HostStats;
+
+extern HostStats host_stats;
+extern const char* host_object_names[HOST_OBJ_COUNT];
+
+// Options the sim sets before starting the app.
+extern bool host_clock_24h;
+extern const char* host_locale;
+extern int host_log_level;
+
+// The simulated clock stands still while the app runs.  When this is
+// above 0, time_ms() adds the host time spent in the current event
+// times this, as a rough stand-in for the watch's slower CPU.
+extern double host_cpu_scale;
+
+// Clock.  The simulated time is real UTC; the offset function
+// gives the watch's local offset (including DST) at a UTC time.
+typedef int32_t (*HostOffsetFunction)(time_t utc);
+
+void host_set_offset_function(HostOffsetFunction fn);
+void host_set_now_ms(int64_t utc_ms);
+int64_t host_now_ms(void);
+time_t host_local_now(void);
+
+// Events.  Each one counts as a wakeup and ends with a redraw.
+void host_deliver_tick(void);
+void host_fire_due_timers(void);
+int64_t host_next_timer_ms(void); // INT64_MAX when nothing is pending
+void host_set_bluetooth(bool connected);
+void host_set_battery(BatteryChargeState state);
+void host_deliver_inbox(const uint8_t* dict, uint16_t size);
+void host_window_disappear(void);
+void host_window_appear(void);
+
+// Wrap anything else the sim does to the app (e.g. a relaunch).
+// The kind and value go to the trace.
+void host_begin_event(const char* kind, uint32_t value);
+void host_end_event(void);
+
+// Event trace, one "time_ms,event,value" line each:
+//   tick, timer, window, launch  wakeups, value 0
+//   bluetooth                    wakeup, value 1 when connected
+//   battery                      wakeup, value is the charge percent
+//   inbox                        wakeup, value is the message bytes
+//   outbox                       message bytes sent
+//   frame                        pixels redrawn at the end of an event
+//   vibe                         milliseconds the motor is on
+// Lines starting with '#' are comments.
+void host_trace_open(FILE* file);
+void host_trace(const char* event, uint64_t value);
+
+// The phone side gets every message the watch sends.
+typedef void (*HostOutboxHandler)(const uint8_t* dict, uint16_t size);
+
+void host_set_outbox_handler(HostOutboxHandler handler);
+
+uint32_t host_objects_live(void);
+
+#endif // HOST_HOST_H
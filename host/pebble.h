@@ -0,0 +1,366 @@
+/*
+Host stand-in for the parts of the Pebble SDK that GotTheTime uses.
+
+Only enough of the API is here to compile src/ with a normal C compiler
+and drive it from the simulation in sim_year.c.  The implementations
+live in pebble_host.c and keep count of everything the watch would
+spend battery on (wakeups, redraws, vibes, messages) and of everything
+that should be freed again (layers, bitmaps, timers, AppSync).
+Persistent storage lasts for the whole run, across relaunches.
+
+Like the firmware, time() returns local time as if it were UTC,
+and localtime() doesn't know about timezones.
+*/
+
+#ifndef HOST_PEBBLE_H
+#define HOST_PEBBLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define ARRAY_LENGTH(array) (sizeof((array))/sizeof((array)[0]))
+#define IS_SIGNED(var) (((typeof(var)) -1) < ((typeof(var)) 0))
+
+// ---------- Logging ------------------------------
+
+typedef enum {
+	APP_LOG_LEVEL_ERROR = 1,
+	APP_LOG_LEVEL_WARNING = 50,
+	APP_LOG_LEVEL_INFO = 100,
+	APP_LOG_LEVEL_DEBUG = 200,
+	APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...)
+	__attribute__((format(printf, 4, 5)));
+
+#define APP_LOG(level, fmt, args...) \
+	app_log(level, __FILE__, __LINE__, fmt, ## args)
+
+// ---------- Resources ------------------------------
+// Same order as the media in appinfo.json.
+
+typedef enum {
+	RESOURCE_ID_IMAGE_MENU_ICON = 1,
+	RESOURCE_ID_FONT_UBUNTU_21,
+	RESOURCE_ID_FONT_UBUNTU_B_SUBSET_49,
+	RESOURCE_ID_IMAGE_WEATHER_NONE,
+	RESOURCE_ID_IMAGE_WEATHER_RAIN,
+	RESOURCE_ID_IMAGE_WEATHER_SNOW,
+	RESOURCE_ID_IMAGE_WEATHER_SUN,
+	RESOURCE_ID_IMAGE_WEATHER_CLOUD,
+} ResourceId;
+
+typedef uint32_t ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+
+// ---------- Time ------------------------------
+
+typedef enum {
+	SECOND_UNIT = 1 << 0,
+	MINUTE_UNIT = 1 << 1,
+	HOUR_UNIT = 1 << 2,
+	DAY_UNIT = 1 << 3,
+	MONTH_UNIT = 1 << 4,
+	YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm* tick_time, TimeUnits units_changed);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+bool clock_is_24h_style(void);
+
+const char* i18n_get_system_locale(void);
+
+time_t host_time(time_t* tloc);
+struct tm* host_localtime(const time_t* timep);
+
+#define time(tloc) host_time(tloc)
+#define localtime(timep) host_localtime(timep)
+
+uint16_t time_ms(time_t* tloc, uint16_t* out_ms);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void* data);
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data);
+void app_timer_cancel(AppTimer* timer_handle);
+
+// ---------- Graphics ------------------------------
+
+typedef struct GPoint {
+	int16_t x;
+	int16_t y;
+} GPoint;
+
+typedef struct GSize {
+	int16_t w;
+	int16_t h;
+} GSize;
+
+typedef struct GRect {
+	GPoint origin;
+	GSize size;
+} GRect;
+
+typedef enum {
+	GColorClear = ~0,
+	GColorBlack = 0,
+	GColorWhite = 1,
+} GColor;
+
+typedef enum {
+	GTextAlignmentLeft,
+	GTextAlignmentCenter,
+	GTextAlignmentRight,
+} GTextAlignment;
+
+typedef enum {
+	GCornerNone = 0,
+} GCornerMask;
+
+typedef struct GContext GContext;
+typedef struct GBitmap GBitmap;
+typedef struct FontInfo* GFont;
+
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+
+GFont fonts_get_system_font(const char* font_key);
+GFont fonts_load_custom_font(ResHandle handle);
+void fonts_unload_custom_font(GFont font);
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id);
+void gbitmap_destroy(GBitmap* bitmap);
+
+void graphics_context_set_stroke_color(GContext* ctx, GColor color);
+void graphics_context_set_fill_color(GContext* ctx, GColor color);
+void graphics_draw_rect(GContext* ctx, GRect rect);
+void graphics_fill_rect(GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+
+// ---------- Layers and windows ------------------------------
+
+typedef struct Layer Layer;
+typedef struct TextLayer TextLayer;
+typedef struct BitmapLayer BitmapLayer;
+typedef struct Window Window;
+
+typedef void (*LayerUpdateProc)(Layer* layer, GContext* ctx);
+
+Layer* layer_create(GRect frame);
+void layer_destroy(Layer* layer);
+void layer_add_child(Layer* parent, Layer* child);
+void layer_remove_from_parent(Layer* child);
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer* layer);
+void layer_set_hidden(Layer* layer, bool hidden);
+GRect layer_get_frame(const Layer* layer);
+GRect layer_get_bounds(const Layer* layer);
+
+TextLayer* text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer* text_layer);
+Layer* text_layer_get_layer(TextLayer* text_layer);
+void text_layer_set_text(TextLayer* text_layer, const char* text);
+const char* text_layer_get_text(TextLayer* text_layer);
+void text_layer_set_text_color(TextLayer* text_layer, GColor color);
+void text_layer_set_background_color(TextLayer* text_layer, GColor color);
+void text_layer_set_text_alignment(TextLayer* text_layer, GTextAlignment text_alignment);
+void text_layer_set_font(TextLayer* text_layer, GFont font);
+
+BitmapLayer* bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer* bitmap_layer);
+Layer* bitmap_layer_get_layer(const BitmapLayer* bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer* bitmap_layer, const GBitmap* bitmap);
+
+typedef void (*WindowHandler)(Window* window);
+
+typedef struct WindowHandlers {
+	WindowHandler load;
+	WindowHandler appear;
+	WindowHandler disappear;
+	WindowHandler unload;
+} WindowHandlers;
+
+Window* window_create(void);
+void window_destroy(Window* window);
+void window_set_window_handlers(Window* window, WindowHandlers handlers);
+void window_set_background_color(Window* window, GColor background_color);
+Layer* window_get_root_layer(const Window* window);
+void window_stack_push(Window* window, bool animated);
+
+// ---------- Vibes ------------------------------
+
+typedef struct {
+	const uint32_t* durations;
+	uint32_t num_segments;
+} VibePattern;
+
+void vibes_enqueue_custom_pattern(VibePattern pattern);
+
+// ---------- Battery and Bluetooth ------------------------------
+
+typedef struct {
+	uint8_t charge_percent;
+	bool is_charging;
+	bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+BatteryChargeState battery_state_service_peek(void);
+
+typedef void (*BluetoothConnectionHandler)(bool connected);
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler);
+void bluetooth_connection_service_unsubscribe(void);
+bool bluetooth_connection_service_peek(void);
+
+// ---------- Dictionaries ------------------------------
+
+typedef enum {
+	DICT_OK = 0,
+	DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+	DICT_INVALID_ARGS = 1 << 2,
+	DICT_INTERNAL_INCONSISTENCY = 1 << 3,
+	DICT_MALLOC_FAILED = 1 << 4,
+} DictionaryResult;
+
+typedef enum {
+	TUPLE_BYTE_ARRAY = 0,
+	TUPLE_CSTRING = 1,
+	TUPLE_UINT = 2,
+	TUPLE_INT = 3,
+} TupleType;
+
+// Same wire layout as the firmware: 7 byte header, then the value.
+typedef struct __attribute__((__packed__)) {
+	uint32_t key;
+	uint8_t type;
+	uint16_t length;
+	union {
+		uint8_t data[0];
+		char cstring[0];
+		uint8_t uint8;
+		uint16_t uint16;
+		uint32_t uint32;
+		int8_t int8;
+		int16_t int16;
+		int32_t int32;
+	} value[];
+} Tuple;
+
+typedef struct Tuplet {
+	TupleType type;
+	uint32_t key;
+	union {
+		struct {
+			const uint8_t* data;
+			const uint16_t length;
+		} bytes;
+		struct {
+			const char* data;
+			const uint16_t length;
+		} cstring;
+		struct {
+			uint32_t storage;
+			const uint16_t width;
+		} integer;
+	};
+} Tuplet;
+
+#define TupletInteger(_key, _integer) \
+	((const Tuplet) { .type = IS_SIGNED(_integer) ? TUPLE_INT : TUPLE_UINT, .key = _key, \
+			  .integer = { .storage = _integer, .width = sizeof(_integer) } })
+
+#define TupletBytes(_key, _data, _length) \
+	((const Tuplet) { .type = TUPLE_BYTE_ARRAY, .key = _key, \
+			  .bytes = { .data = _data, .length = _length } })
+
+typedef struct DictionaryIterator {
+	uint8_t* dictionary; // First byte is the tuple count
+	const uint8_t* end;
+	Tuple* cursor;
+} DictionaryIterator;
+
+DictionaryResult dict_write_begin(DictionaryIterator* iter, uint8_t* const buffer, const uint16_t size);
+DictionaryResult dict_write_tuplet(DictionaryIterator* iter, const Tuplet* const tuplet);
+DictionaryResult dict_write_data(DictionaryIterator* iter, const uint32_t key, const uint8_t* const data, const uint16_t size);
+uint32_t dict_write_end(DictionaryIterator* iter);
+Tuple* dict_read_begin_from_buffer(DictionaryIterator* iter, const uint8_t* const buffer, const uint16_t size);
+Tuple* dict_read_next(DictionaryIterator* iter);
+Tuple* dict_find(const DictionaryIterator* iter, const uint32_t key);
+
+// ---------- AppMessage and AppSync ------------------------------
+
+typedef enum {
+	APP_MSG_OK = 0,
+	APP_MSG_SEND_TIMEOUT = 1 << 1,
+	APP_MSG_SEND_REJECTED = 1 << 2,
+	APP_MSG_NOT_CONNECTED = 1 << 3,
+	APP_MSG_APP_NOT_RUNNING = 1 << 4,
+	APP_MSG_INVALID_ARGS = 1 << 5,
+	APP_MSG_BUSY = 1 << 6,
+	APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+	APP_MSG_ALREADY_RELEASED = 1 << 9,
+	APP_MSG_CALLBACK_ALREADY_REGISTERED = 1 << 10,
+	APP_MSG_CALLBACK_NOT_REGISTERED = 1 << 11,
+	APP_MSG_OUT_OF_MEMORY = 1 << 12,
+	APP_MSG_CLOSED = 1 << 13,
+	APP_MSG_INTERNAL_ERROR = 1 << 14,
+} AppMessageResult;
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+AppMessageResult app_message_outbox_begin(DictionaryIterator** iterator);
+AppMessageResult app_message_outbox_send(void);
+
+typedef void (*AppSyncTupleChangedCallback)(const uint32_t key, const Tuple* new_tuple,
+					    const Tuple* old_tuple, void* context);
+typedef void (*AppSyncErrorCallback)(DictionaryResult dict_error,
+				     AppMessageResult app_message_error, void* context);
+
+typedef struct AppSync {
+	uint8_t* buffer;
+	uint16_t buffer_size;
+	uint16_t used;
+	AppSyncTupleChangedCallback changed;
+	AppSyncErrorCallback error;
+	void* context;
+	bool active;
+} AppSync;
+
+void app_sync_init(AppSync* s, uint8_t* buffer, const uint16_t buffer_size,
+		   const Tuplet* const keys_and_initial_values, const uint8_t count,
+		   AppSyncTupleChangedCallback tuple_changed_callback,
+		   AppSyncErrorCallback error_callback, void* context);
+void app_sync_deinit(AppSync* s);
+const Tuple* app_sync_get(const AppSync* s, const uint32_t key);
+
+// ---------- Persistent storage ------------------------------
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+typedef int32_t status_t;
+#define S_SUCCESS 0
+#define E_DOES_NOT_EXIST -4
+
+bool persist_exists(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size);
+status_t persist_write_int(const uint32_t key, const int32_t value);
+int persist_write_data(const uint32_t key, const void* data, const size_t size);
+status_t persist_delete(const uint32_t key);
+
+// ---------- Event loop ------------------------------
+
+void app_event_loop(void);
+
+#endif // HOST_PEBBLE_H
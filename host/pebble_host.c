@@ -0,0 +1,1072 @@
+/*
+Host implementation of the SDK calls declared in pebble.h.
+
+Nothing here draws anything.  Layers remember their frame and whether
+they're dirty or hidden, so each event can be charged for the pixels
+it would redraw, and every object the app creates is counted so leaks
+show up as live objects that don't go away.
+*/
+
+#include <pebble.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+#include "host.h"
+
+#define HOST_SCREEN_WIDTH  144
+#define HOST_SCREEN_HEIGHT 168
+
+#define HOST_MAX_LAYERS 64
+#define HOST_MAX_TIMERS 32
+#define HOST_MAX_SYNCS 4
+#define HOST_MAX_CHURN 8
+#define HOST_DICT_SCRATCH 1024
+#define HOST_MAX_PERSIST 16
+
+struct Layer {
+	GRect frame;
+	LayerUpdateProc update_proc;
+	Layer* parent;
+	bool dirty;
+	bool hidden;
+};
+
+struct TextLayer {
+	Layer layer;
+	const char* text;
+};
+
+struct BitmapLayer {
+	Layer layer;
+	const GBitmap* bitmap;
+};
+
+struct Window {
+	Layer root;
+	WindowHandlers handlers;
+	bool loaded;
+	bool on_screen;
+};
+
+struct GBitmap {
+	uint32_t resource_id;
+};
+
+struct FontInfo {
+	uint32_t resource_id;
+};
+
+struct GContext {
+	GColor stroke_color;
+	GColor fill_color;
+};
+
+typedef struct {
+	uint32_t key;
+	bool used;
+	uint16_t size;
+	uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+struct AppTimer {
+	int64_t fire_ms;
+	AppTimerCallback callback;
+	void* data;
+	bool pending;
+};
+
+HostStats host_stats;
+
+const char* host_object_names[HOST_OBJ_COUNT] = {
+	"windows", "layers", "text layers", "bitmap layers", "bitmaps", "fonts",
+};
+
+bool host_clock_24h = false;
+const char* host_locale = "en_US";
+int host_log_level = 0;
+double host_cpu_scale = 0;
+
+static int64_t now_ms;
+static HostOffsetFunction offset_fn;
+
+static Layer* layers[HOST_MAX_LAYERS];
+static AppTimer timers[HOST_MAX_TIMERS];
+static AppSync* syncs[HOST_MAX_SYNCS];
+static Window* top_window;
+
+static TickHandler tick_handler;
+static TimeUnits tick_units;
+static struct tm last_tick;
+static bool have_last_tick;
+
+static BatteryStateHandler battery_handler;
+static BatteryChargeState battery_state = { .charge_percent = 100 };
+static BluetoothConnectionHandler bluetooth_handler;
+static bool bluetooth_connected = true;
+
+static bool app_message_is_open;
+static uint32_t inbound_size;
+static uint32_t outbound_size;
+static uint8_t* outbox_buffer;
+static DictionaryIterator outbox_iter;
+static bool outbox_busy;
+static HostOutboxHandler outbox_handler;
+
+static PersistEntry persist[HOST_MAX_PERSIST];
+
+static FILE* trace_file;
+static struct timespec event_started; // Host clock, for host_cpu_scale
+
+// Resources destroyed during the current event, to spot reloads.
+static uint32_t destroyed_resources[HOST_MAX_CHURN];
+static uint8_t destroyed_count;
+
+// ---------- Bookkeeping ------------------------------
+
+static void object_created(HostObjectKind kind) {
+	host_stats.live[kind]++;
+	if (host_stats.live[kind] > host_stats.peak[kind]) {
+		host_stats.peak[kind] = host_stats.live[kind];
+	}
+}
+
+static void object_destroyed(HostObjectKind kind) {
+	if (host_stats.live[kind] == 0) {
+		fprintf(stderr, "host: %s destroyed more often than created\n",
+			host_object_names[kind]);
+		return;
+	}
+	host_stats.live[kind]--;
+}
+
+uint32_t host_objects_live(void) {
+	uint32_t total = 0;
+	for (int i = 0; i < HOST_OBJ_COUNT; i++) {
+		total += host_stats.live[i];
+	}
+	return total;
+}
+
+static void register_layer(Layer* layer) {
+	for (int i = 0; i < HOST_MAX_LAYERS; i++) {
+		if (layers[i] == NULL) {
+			layers[i] = layer;
+			return;
+		}
+	}
+	fprintf(stderr, "host: more than %d layers\n", HOST_MAX_LAYERS);
+	abort();
+}
+
+static void unregister_layer(Layer* layer) {
+	for (int i = 0; i < HOST_MAX_LAYERS; i++) {
+		if (layers[i] == layer) {
+			layers[i] = NULL;
+		}
+		else if (layers[i] && layers[i]->parent == layer) {
+			layers[i]->parent = NULL;
+		}
+	}
+}
+
+static void layer_init(Layer* layer, GRect frame) {
+	memset(layer, 0, sizeof(*layer));
+	layer->frame = frame;
+	layer->dirty = true;
+	register_layer(layer);
+}
+
+void host_trace_open(FILE* file) {
+	trace_file = file;
+	fprintf(trace_file, "# time_ms,event,value\n");
+}
+
+void host_trace(const char* event, uint64_t value) {
+	if (trace_file) {
+		fprintf(trace_file, "%lld,%s,%llu\n", (long long) now_ms, event, (unsigned long long) value);
+	}
+}
+
+// ---------- Logging and resources ------------------------------
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...) {
+	if (log_level > host_log_level) {
+		return;
+	}
+
+	time_t local = host_local_now();
+	struct tm t;
+	gmtime_r(&local, &t);
+
+	char when[32];
+	strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &t);
+	printf("[%s] %s:%d ", when, src_filename, src_line_number);
+
+	va_list args;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	printf("\n");
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+	return resource_id;
+}
+
+// ---------- Time ------------------------------
+
+void host_set_offset_function(HostOffsetFunction fn) {
+	offset_fn = fn;
+}
+
+void host_set_now_ms(int64_t utc_ms) {
+	now_ms = utc_ms;
+}
+
+int64_t host_now_ms(void) {
+	return now_ms;
+}
+
+time_t host_local_now(void) {
+	time_t utc = now_ms / 1000;
+	return utc + (offset_fn ? offset_fn(utc) : 0);
+}
+
+time_t host_time(time_t* tloc) {
+	time_t t = host_local_now();
+	if (tloc) {
+		*tloc = t;
+	}
+	return t;
+}
+
+uint16_t time_ms(time_t* tloc, uint16_t* out_ms) {
+	time_t utc = now_ms / 1000;
+	int64_t local_ms = now_ms + (host_local_now() - utc) * 1000LL;
+
+	if (host_cpu_scale > 0) {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		int64_t ns = (ts.tv_sec - event_started.tv_sec) * 1000000000LL +
+			(ts.tv_nsec - event_started.tv_nsec);
+		local_ms += (int64_t) (ns * host_cpu_scale / 1000000);
+	}
+
+	uint16_t ms = local_ms % 1000;
+	if (tloc) {
+		*tloc = local_ms / 1000;
+	}
+	if (out_ms) {
+		*out_ms = ms;
+	}
+	return ms;
+}
+
+struct tm* host_localtime(const time_t* timep) {
+	static struct tm result;
+	return gmtime_r(timep, &result);
+}
+
+bool clock_is_24h_style(void) {
+	return host_clock_24h;
+}
+
+const char* i18n_get_system_locale(void) {
+	return host_locale;
+}
+
+void tick_timer_service_subscribe(TimeUnits units, TickHandler handler) {
+	tick_units = units;
+	tick_handler = handler;
+	have_last_tick = false;
+}
+
+void tick_timer_service_unsubscribe(void) {
+	tick_handler = NULL;
+}
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data) {
+	AppTimer* slot = NULL;
+
+	for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+		AppTimer* t = &timers[i];
+		if (t->pending) {
+			if (t->callback == callback && t->data == callback_data) {
+				host_stats.stacked_timers++;
+			}
+		}
+		else if (slot == NULL) {
+			slot = t;
+		}
+	}
+
+	if (slot == NULL) {
+		fprintf(stderr, "host: more than %d timers pending\n", HOST_MAX_TIMERS);
+		return NULL;
+	}
+
+	slot->fire_ms = now_ms + timeout_ms;
+	slot->callback = callback;
+	slot->data = callback_data;
+	slot->pending = true;
+
+	host_stats.timers_pending++;
+	if (host_stats.timers_pending > host_stats.timers_peak) {
+		host_stats.timers_peak = host_stats.timers_pending;
+	}
+	return slot;
+}
+
+void app_timer_cancel(AppTimer* timer) {
+	if (timer && timer->pending) {
+		timer->pending = false;
+		host_stats.timers_pending--;
+	}
+}
+
+// ---------- Graphics ------------------------------
+
+GFont fonts_get_system_font(const char* font_key) {
+	static struct FontInfo system_font;
+	return &system_font;
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+	GFont font = malloc(sizeof(*font));
+	font->resource_id = handle;
+	object_created(HOST_OBJ_FONT);
+	return font;
+}
+
+void fonts_unload_custom_font(GFont font) {
+	free(font);
+	object_destroyed(HOST_OBJ_FONT);
+}
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id) {
+	for (int i = 0; i < destroyed_count; i++) {
+		if (destroyed_resources[i] == resource_id) {
+			host_stats.bitmap_churn++;
+			break;
+		}
+	}
+
+	GBitmap* bitmap = malloc(sizeof(*bitmap));
+	bitmap->resource_id = resource_id;
+	host_stats.bitmap_creates++;
+	object_created(HOST_OBJ_BITMAP);
+	return bitmap;
+}
+
+void gbitmap_destroy(GBitmap* bitmap) {
+	if (bitmap == NULL) {
+		return;
+	}
+	if (destroyed_count < HOST_MAX_CHURN) {
+		destroyed_resources[destroyed_count++] = bitmap->resource_id;
+	}
+	free(bitmap);
+	object_destroyed(HOST_OBJ_BITMAP);
+}
+
+void graphics_context_set_stroke_color(GContext* ctx, GColor color) {
+	ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext* ctx, GColor color) {
+	ctx->fill_color = color;
+}
+
+void graphics_draw_rect(GContext* ctx, GRect rect) {
+}
+
+void graphics_fill_rect(GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+}
+
+// ---------- Layers ------------------------------
+
+Layer* layer_create(GRect frame) {
+	Layer* layer = malloc(sizeof(*layer));
+	layer_init(layer, frame);
+	object_created(HOST_OBJ_LAYER);
+	return layer;
+}
+
+void layer_destroy(Layer* layer) {
+	if (layer == NULL) {
+		return;
+	}
+	unregister_layer(layer);
+	free(layer);
+	object_destroyed(HOST_OBJ_LAYER);
+}
+
+void layer_add_child(Layer* parent, Layer* child) {
+	child->parent = parent;
+	child->dirty = true;
+}
+
+void layer_remove_from_parent(Layer* child) {
+	child->parent = NULL;
+}
+
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc) {
+	layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer* layer) {
+	layer->dirty = true;
+}
+
+// Hidden, or inside a hidden layer.
+static bool layer_hidden(const Layer* layer) {
+	for (; layer != NULL; layer = layer->parent) {
+		if (layer->hidden) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void layer_set_hidden(Layer* layer, bool hidden) {
+	if (layer->hidden == hidden) {
+		return;
+	}
+	layer->hidden = hidden;
+	if (hidden) {
+		return;
+	}
+	// Showing it again redraws it and everything in it.
+	for (int i = 0; i < HOST_MAX_LAYERS; i++) {
+		if (layers[i] && !layer_hidden(layers[i])) {
+			for (Layer* up = layers[i]; up != NULL; up = up->parent) {
+				if (up == layer) {
+					layers[i]->dirty = true;
+					break;
+				}
+			}
+		}
+	}
+}
+
+GRect layer_get_frame(const Layer* layer) {
+	return layer->frame;
+}
+
+GRect layer_get_bounds(const Layer* layer) {
+	return (GRect) { .origin = { 0, 0 }, .size = layer->frame.size };
+}
+
+TextLayer* text_layer_create(GRect frame) {
+	TextLayer* text_layer = malloc(sizeof(*text_layer));
+	layer_init(&text_layer->layer, frame);
+	text_layer->text = "";
+	object_created(HOST_OBJ_TEXT_LAYER);
+	return text_layer;
+}
+
+void text_layer_destroy(TextLayer* text_layer) {
+	if (text_layer == NULL) {
+		return;
+	}
+	unregister_layer(&text_layer->layer);
+	free(text_layer);
+	object_destroyed(HOST_OBJ_TEXT_LAYER);
+}
+
+Layer* text_layer_get_layer(TextLayer* text_layer) {
+	return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer* text_layer, const char* text) {
+	text_layer->text = text;
+	text_layer->layer.dirty = true;
+	host_stats.text_updates++;
+}
+
+const char* text_layer_get_text(TextLayer* text_layer) {
+	return text_layer->text;
+}
+
+void text_layer_set_text_color(TextLayer* text_layer, GColor color) {
+}
+
+void text_layer_set_background_color(TextLayer* text_layer, GColor color) {
+}
+
+void text_layer_set_text_alignment(TextLayer* text_layer, GTextAlignment text_alignment) {
+}
+
+void text_layer_set_font(TextLayer* text_layer, GFont font) {
+}
+
+BitmapLayer* bitmap_layer_create(GRect frame) {
+	BitmapLayer* bitmap_layer = malloc(sizeof(*bitmap_layer));
+	layer_init(&bitmap_layer->layer, frame);
+	bitmap_layer->bitmap = NULL;
+	object_created(HOST_OBJ_BITMAP_LAYER);
+	return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer* bitmap_layer) {
+	if (bitmap_layer == NULL) {
+		return;
+	}
+	unregister_layer(&bitmap_layer->layer);
+	free(bitmap_layer);
+	object_destroyed(HOST_OBJ_BITMAP_LAYER);
+}
+
+Layer* bitmap_layer_get_layer(const BitmapLayer* bitmap_layer) {
+	return (Layer*) &bitmap_layer->layer;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer* bitmap_layer, const GBitmap* bitmap) {
+	bitmap_layer->bitmap = bitmap;
+	bitmap_layer->layer.dirty = true;
+}
+
+// ---------- Windows ------------------------------
+
+Window* window_create(void) {
+	Window* window = calloc(1, sizeof(*window));
+	window->root.frame = (GRect) { .origin = { 0, 0 },
+				       .size = { HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT } };
+	object_created(HOST_OBJ_WINDOW);
+	return window;
+}
+
+void window_destroy(Window* window) {
+	if (window == top_window) {
+		if (window->on_screen && window->handlers.disappear) {
+			window->handlers.disappear(window);
+		}
+		window->on_screen = false;
+		if (window->loaded && window->handlers.unload) {
+			window->handlers.unload(window);
+		}
+		window->loaded = false;
+		top_window = NULL;
+	}
+	unregister_layer(&window->root);
+	free(window);
+	object_destroyed(HOST_OBJ_WINDOW);
+}
+
+void window_set_window_handlers(Window* window, WindowHandlers handlers) {
+	window->handlers = handlers;
+}
+
+void window_set_background_color(Window* window, GColor background_color) {
+	window->root.dirty = true;
+}
+
+Layer* window_get_root_layer(const Window* window) {
+	return (Layer*) &window->root;
+}
+
+void window_stack_push(Window* window, bool animated) {
+	top_window = window;
+	if (!window->loaded) {
+		window->loaded = true;
+		if (window->handlers.load) {
+			window->handlers.load(window);
+		}
+	}
+	host_window_appear();
+}
+
+void host_window_disappear(void) {
+	if (top_window == NULL || !top_window->on_screen) {
+		return;
+	}
+	top_window->on_screen = false;
+	if (top_window->handlers.disappear) {
+		top_window->handlers.disappear(top_window);
+	}
+}
+
+void host_window_appear(void) {
+	if (top_window == NULL || top_window->on_screen) {
+		return;
+	}
+	top_window->on_screen = true;
+	top_window->root.dirty = true;
+	if (top_window->handlers.appear) {
+		top_window->handlers.appear(top_window);
+	}
+}
+
+// ---------- Vibes, battery and Bluetooth ------------------------------
+
+void vibes_enqueue_custom_pattern(VibePattern pattern) {
+	// Even segments are on, odd segments are off.
+	uint32_t on_ms = 0;
+	for (uint32_t i = 0; i < pattern.num_segments; i += 2) {
+		on_ms += pattern.durations[i];
+	}
+	host_stats.vibes++;
+	host_stats.vibe_ms += on_ms;
+	host_trace("vibe", on_ms);
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+	battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+	battery_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+	return battery_state;
+}
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler) {
+	bluetooth_handler = handler;
+}
+
+void bluetooth_connection_service_unsubscribe(void) {
+	bluetooth_handler = NULL;
+}
+
+bool bluetooth_connection_service_peek(void) {
+	return bluetooth_connected;
+}
+
+// ---------- Dictionaries ------------------------------
+
+#define TUPLE_SIZE(t) (sizeof(Tuple) + (t)->length)
+#define NEXT_TUPLE(t) ((Tuple*) ((uint8_t*) (t) + TUPLE_SIZE(t)))
+
+DictionaryResult dict_write_begin(DictionaryIterator* iter, uint8_t* const buffer, const uint16_t size) {
+	if (iter == NULL || buffer == NULL || size < 1) {
+		return DICT_INVALID_ARGS;
+	}
+	iter->dictionary = buffer;
+	iter->end = buffer + size;
+	iter->cursor = (Tuple*) (buffer + 1);
+	buffer[0] = 0;
+	return DICT_OK;
+}
+
+static DictionaryResult dict_write_raw(DictionaryIterator* iter, uint32_t key, TupleType type,
+				       const void* data, uint16_t length) {
+	if ((const uint8_t*) iter->cursor + sizeof(Tuple) + length > iter->end) {
+		return DICT_NOT_ENOUGH_STORAGE;
+	}
+	iter->cursor->key = key;
+	iter->cursor->type = type;
+	iter->cursor->length = length;
+	memcpy(iter->cursor->value, data, length);
+	iter->cursor = NEXT_TUPLE(iter->cursor);
+	iter->dictionary[0]++;
+	return DICT_OK;
+}
+
+DictionaryResult dict_write_tuplet(DictionaryIterator* iter, const Tuplet* const tuplet) {
+	switch (tuplet->type) {
+	case TUPLE_BYTE_ARRAY:
+		return dict_write_raw(iter, tuplet->key, tuplet->type,
+				     tuplet->bytes.data, tuplet->bytes.length);
+	case TUPLE_CSTRING:
+		return dict_write_raw(iter, tuplet->key, tuplet->type,
+				     tuplet->cstring.data, tuplet->cstring.length);
+	case TUPLE_UINT:
+	case TUPLE_INT:
+		// Little endian, so the low bytes come first.
+		return dict_write_raw(iter, tuplet->key, tuplet->type,
+				     &tuplet->integer.storage, tuplet->integer.width);
+	}
+	return DICT_INVALID_ARGS;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator* iter, const uint32_t key, const uint8_t* const data, const uint16_t size) {
+	return dict_write_raw(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+uint32_t dict_write_end(DictionaryIterator* iter) {
+	uint32_t size = (uint8_t*) iter->cursor - iter->dictionary;
+	iter->end = (uint8_t*) iter->cursor;
+	iter->cursor = (Tuple*) (iter->dictionary + 1);
+	return size;
+}
+
+Tuple* dict_read_begin_from_buffer(DictionaryIterator* iter, const uint8_t* const buffer, const uint16_t size) {
+	iter->dictionary = (uint8_t*) buffer;
+	iter->end = buffer + size;
+	iter->cursor = (Tuple*) (buffer + 1);
+	if (size < 1 + sizeof(Tuple) || buffer[0] == 0) {
+		return NULL;
+	}
+	return iter->cursor;
+}
+
+Tuple* dict_read_next(DictionaryIterator* iter) {
+	Tuple* next = NEXT_TUPLE(iter->cursor);
+	if ((const uint8_t*) next + sizeof(Tuple) > iter->end ||
+	    (const uint8_t*) NEXT_TUPLE(next) > iter->end) {
+		return NULL;
+	}
+	iter->cursor = next;
+	return next;
+}
+
+Tuple* dict_find(const DictionaryIterator* iter, const uint32_t key) {
+	DictionaryIterator it;
+	for (Tuple* t = dict_read_begin_from_buffer(&it, iter->dictionary, iter->end - iter->dictionary);
+	     t != NULL; t = dict_read_next(&it)) {
+		if (t->key == key) {
+			return t;
+		}
+	}
+	return NULL;
+}
+
+// ---------- AppMessage and AppSync ------------------------------
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+	if (app_message_is_open) {
+		return APP_MSG_OK;
+	}
+	app_message_is_open = true;
+	inbound_size = size_inbound;
+	outbound_size = size_outbound;
+	outbox_buffer = malloc(outbound_size);
+	return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator** iterator) {
+	*iterator = NULL;
+	if (!app_message_is_open) {
+		return APP_MSG_INVALID_ARGS;
+	}
+	if (outbox_busy) {
+		return APP_MSG_BUSY;
+	}
+	dict_write_begin(&outbox_iter, outbox_buffer, outbound_size);
+	*iterator = &outbox_iter;
+	outbox_busy = true;
+	return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+	if (!outbox_busy) {
+		return APP_MSG_INVALID_ARGS;
+	}
+	if (!bluetooth_connected) {
+		return APP_MSG_NOT_CONNECTED;
+	}
+
+	uint16_t size = outbox_iter.end - outbox_iter.dictionary;
+	host_stats.outbox_messages++;
+	host_stats.outbox_bytes += size;
+	host_trace("outbox", size);
+	if (outbox_handler) {
+		outbox_handler(outbox_buffer, size);
+	}
+	return APP_MSG_OK;
+}
+
+void host_set_outbox_handler(HostOutboxHandler handler) {
+	outbox_handler = handler;
+}
+
+void app_sync_init(AppSync* s, uint8_t* buffer, const uint16_t buffer_size,
+		   const Tuplet* const keys_and_initial_values, const uint8_t count,
+		   AppSyncTupleChangedCallback tuple_changed_callback,
+		   AppSyncErrorCallback error_callback, void* context) {
+	host_stats.sync_inits++;
+	if (s->active) {
+		host_stats.sync_reinits++;
+	}
+	else {
+		for (int i = 0; i < HOST_MAX_SYNCS; i++) {
+			if (syncs[i] == NULL) {
+				syncs[i] = s;
+				break;
+			}
+		}
+	}
+
+	s->buffer = buffer;
+	s->buffer_size = buffer_size;
+	s->changed = tuple_changed_callback;
+	s->error = error_callback;
+	s->context = context;
+	s->active = true;
+
+	DictionaryIterator iter;
+	DictionaryResult res = dict_write_begin(&iter, buffer, buffer_size);
+	for (int i = 0; i < count && res == DICT_OK; i++) {
+		res = dict_write_tuplet(&iter, &keys_and_initial_values[i]);
+	}
+	if (res != DICT_OK) {
+		s->used = 0;
+		error_callback(res, APP_MSG_OK, context);
+		return;
+	}
+	s->used = dict_write_end(&iter);
+
+	for (Tuple* t = dict_read_begin_from_buffer(&iter, buffer, s->used);
+	     t != NULL; t = dict_read_next(&iter)) {
+		tuple_changed_callback(t->key, t, NULL, context);
+	}
+}
+
+void app_sync_deinit(AppSync* s) {
+	host_stats.sync_deinits++;
+	s->active = false;
+	for (int i = 0; i < HOST_MAX_SYNCS; i++) {
+		if (syncs[i] == s) {
+			syncs[i] = NULL;
+		}
+	}
+}
+
+const Tuple* app_sync_get(const AppSync* s, const uint32_t key) {
+	DictionaryIterator iter = { .dictionary = s->buffer, .end = s->buffer + s->used };
+	return dict_find(&iter, key);
+}
+
+// Like the firmware, only keys given to app_sync_init are kept.
+static void sync_merge(AppSync* s, const Tuple* incoming) {
+	static uint8_t merged[HOST_DICT_SCRATCH];
+	static uint8_t old_copy[HOST_DICT_SCRATCH];
+
+	if (app_sync_get(s, incoming->key) == NULL) {
+		return;
+	}
+
+	DictionaryIterator in;
+	DictionaryIterator out;
+	DictionaryResult res = dict_write_begin(&out, merged, s->buffer_size);
+	const Tuple* old = NULL;
+	for (Tuple* t = dict_read_begin_from_buffer(&in, s->buffer, s->used);
+	     t != NULL && res == DICT_OK; t = dict_read_next(&in)) {
+		const Tuple* src = t;
+		if (t->key == incoming->key) {
+			memcpy(old_copy, t, TUPLE_SIZE(t));
+			old = (const Tuple*) old_copy;
+			src = incoming;
+		}
+		res = dict_write_raw(&out, src->key, src->type, src->value, src->length);
+	}
+
+	if (res != DICT_OK) {
+		host_stats.sync_errors++;
+		s->error(res, APP_MSG_OK, s->context);
+		return;
+	}
+
+	s->used = dict_write_end(&out);
+	memcpy(s->buffer, merged, s->used);
+	s->changed(incoming->key, app_sync_get(s, incoming->key), old, s->context);
+}
+
+// ---------- Persistent storage ------------------------------
+
+static PersistEntry* persist_find(uint32_t key, bool create) {
+	PersistEntry* unused = NULL;
+	for (int i = 0; i < HOST_MAX_PERSIST; i++) {
+		if (persist[i].used && persist[i].key == key) {
+			return &persist[i];
+		}
+		if (!persist[i].used && unused == NULL) {
+			unused = &persist[i];
+		}
+	}
+	if (create && unused) {
+		unused->used = true;
+		unused->key = key;
+		unused->size = 0;
+		return unused;
+	}
+	return NULL;
+}
+
+bool persist_exists(const uint32_t key) {
+	return persist_find(key, false) != NULL;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+	int32_t value = 0;
+	persist_read_data(key, &value, sizeof(value));
+	return value;
+}
+
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size) {
+	PersistEntry* e = persist_find(key, false);
+	if (e == NULL) {
+		return E_DOES_NOT_EXIST;
+	}
+	size_t size = (e->size < buffer_size ? e->size : buffer_size);
+	memcpy(buffer, e->data, size);
+	return size;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value) {
+	int res = persist_write_data(key, &value, sizeof(value));
+	return (res < 0 ? res : S_SUCCESS);
+}
+
+int persist_write_data(const uint32_t key, const void* data, const size_t size) {
+	PersistEntry* e = persist_find(key, true);
+	if (e == NULL) {
+		fprintf(stderr, "host: persistent storage full\n");
+		abort();
+	}
+	e->size = (size < PERSIST_DATA_MAX_LENGTH ? size : PERSIST_DATA_MAX_LENGTH);
+	memcpy(e->data, data, e->size);
+	host_stats.persist_writes++;
+	return e->size;
+}
+
+status_t persist_delete(const uint32_t key) {
+	PersistEntry* e = persist_find(key, false);
+	if (e == NULL) {
+		return E_DOES_NOT_EXIST;
+	}
+	e->used = false;
+	return S_SUCCESS;
+}
+
+// ---------- Event delivery ------------------------------
+
+void host_begin_event(const char* kind, uint32_t value) {
+	clock_gettime(CLOCK_MONOTONIC, &event_started);
+	host_stats.wakeups++;
+	host_trace(kind, value);
+	destroyed_count = 0;
+}
+
+void host_end_event(void) {
+	static GContext ctx;
+	uint32_t area = 0;
+
+	for (int i = 0; i < HOST_MAX_LAYERS; i++) {
+		Layer* layer = layers[i];
+		if (layer == NULL || !layer->dirty || layer_hidden(layer)) {
+			continue;
+		}
+		layer->dirty = false;
+		host_stats.layer_redraws++;
+		area += layer->frame.size.w * layer->frame.size.h;
+		if (layer->update_proc) {
+			layer->update_proc(layer, &ctx);
+		}
+	}
+
+	if (area > 0) {
+		host_stats.frames++;
+		host_stats.redraw_area += area;
+		host_trace("frame", area);
+	}
+	outbox_busy = false;
+	destroyed_count = 0;
+}
+
+void host_deliver_tick(void) {
+	time_t local = host_local_now();
+	static struct tm now;
+	gmtime_r(&local, &now);
+
+	TimeUnits changed = SECOND_UNIT | MINUTE_UNIT;
+	if (!have_last_tick || now.tm_hour != last_tick.tm_hour) changed |= HOUR_UNIT;
+	if (!have_last_tick || now.tm_mday != last_tick.tm_mday) changed |= DAY_UNIT;
+	if (!have_last_tick || now.tm_mon != last_tick.tm_mon) changed |= MONTH_UNIT;
+	if (!have_last_tick || now.tm_year != last_tick.tm_year) changed |= YEAR_UNIT;
+	last_tick = now;
+	have_last_tick = true;
+
+	if (tick_handler == NULL || !(changed & tick_units)) {
+		return;
+	}
+
+	host_begin_event("tick", 0);
+	host_stats.ticks++;
+	tick_handler(&now, changed);
+	host_end_event();
+}
+
+int64_t host_next_timer_ms(void) {
+	int64_t next = INT64_MAX;
+	for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+		if (timers[i].pending && timers[i].fire_ms < next) {
+			next = timers[i].fire_ms;
+		}
+	}
+	return next;
+}
+
+void host_fire_due_timers(void) {
+	for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+		AppTimer* t = &timers[i];
+		if (!t->pending || t->fire_ms > now_ms) {
+			continue;
+		}
+		t->pending = false;
+		host_stats.timers_pending--;
+
+		host_begin_event("timer", 0);
+		host_stats.timers_fired++;
+		t->callback(t->data);
+		host_end_event();
+	}
+}
+
+void host_set_bluetooth(bool connected) {
+	bluetooth_connected = connected;
+	if (bluetooth_handler == NULL) {
+		return;
+	}
+
+	host_begin_event("bluetooth", connected);
+	host_stats.bluetooth_events++;
+	bluetooth_handler(connected);
+	host_end_event();
+}
+
+void host_set_battery(BatteryChargeState state) {
+	battery_state = state;
+	if (battery_handler == NULL) {
+		return;
+	}
+
+	host_begin_event("battery", state.charge_percent);
+	host_stats.battery_events++;
+	battery_handler(state);
+	host_end_event();
+}
+
+void host_deliver_inbox(const uint8_t* dict, uint16_t size) {
+	if (!app_message_is_open) {
+		host_stats.inbox_dropped++;
+		return;
+	}
+
+	host_begin_event("inbox", size);
+	host_stats.inbox_messages++;
+	host_stats.inbox_bytes += size;
+
+	if (size > inbound_size) {
+		host_stats.inbox_dropped++;
+		for (int i = 0; i < HOST_MAX_SYNCS; i++) {
+			if (syncs[i]) {
+				host_stats.sync_errors++;
+				syncs[i]->error(DICT_OK, APP_MSG_BUFFER_OVERFLOW, syncs[i]->context);
+			}
+		}
+	}
+	else {
+		for (int i = 0; i < HOST_MAX_SYNCS; i++) {
+			DictionaryIterator iter;
+			for (Tuple* t = dict_read_begin_from_buffer(&iter, dict, size);
+			     syncs[i] && t != NULL; t = dict_read_next(&iter)) {
+				sync_merge(syncs[i], t);
+			}
+		}
+	}
+
+	host_end_event();
+}
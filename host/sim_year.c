@@ -0,0 +1,994 @@
+/*
+Runs the watchface through a simulated year on the host.
+
+The clock is fake and deterministic (seeded), so a year of minute
+ticks, Bluetooth drops, phone updates, notifications covering the
+face and daily relaunches takes a few seconds.  Along the way it
+checks the time text against real timezone rules, watches for things
+that pile up (AppSync, timers, bitmaps, layers) and adds up the
+wakeups and redraw work the watch would have done.  It exits non-zero
+when a check fails that isn't on the list of expected failures below.
+
+The watch is assumed to be in US Eastern time, like the offsets
+hard coded in draw_time().
+
+Usage: gtt_sim [-y year] [-d days] [-s seed] [-r refresh_minutes] [-2] [-v]
+               [-t trace_file] [-x features] [-b percent] [-l locale]
+               [-w forecast_hours] [-c cpu_scale]
+
+-r is how often the phone pushes an update.  -t writes the event
+trace described in host.h, for tools/power_model.py.  -x turns
+features of the face off, a comma separated list of the names in
+feature_names below, or "all".  -b is the low battery threshold.
+The phone sends both as the settings the first time the watch asks it
+for data.  Like the phone app, the simulated phone only sends what the
+watch says it wants, and doesn't push at all when nothing does.  -w is
+how often the phone pushes a 24 hour forecast (whenever the watch
+asks, as well); -w 0 makes it send only the current conditions with
+every update, like older phone apps.
+
+The phone sends its integers as small as their type on even days and
+4 bytes wide on odd days, the worst case the watch has to take from
+any companion app.  Anything the watch's AppSync can't take counts as
+a sync error.  Its clock runs 90 seconds ahead of the watch's, so some
+forecasts start at the next hour.
+
+At the end the phone asks for the handler latency summary
+(DEBUG_LATENCY), and the report shows it next to the histograms the
+app keeps.  The simulated clock doesn't move while a handler runs, so
+everything takes 0 ms unless -c is given: then the host's own time in
+each event, times cpu_scale, is added to time_ms().
+*/
+
+#include <pebble.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "host.h"
+#include "latency.h"
+
+#define LOCAL_ZONE "EST5EDT,M3.2.0,M11.1.0"     // The watch
+#define TZ1_ZONE   "PST8PDT,M3.2.0,M11.1.0"     // US Pacific
+#define TZ2_ZONE   "CET-1CEST,M3.5.0,M10.5.0/3" // Central Europe
+#define BEATS_OFFSET (60 * 60)                 // Biel Mean Time, UTC+1 all year
+
+#define SECOND_MS 1000LL
+#define MINUTE_MS (60 * SECOND_MS)
+#define HOUR_MS   (60 * MINUTE_MS)
+#define DAY_MS    (24 * HOUR_MS)
+
+#define PHONE_REPLY_MS 1500 // Phone round trip after the watch asks
+#define PHONE_CLOCK_AHEAD_MS (90 * SECOND_MS) // The phone's clock isn't the watch's
+
+#define MAX_RUNS 6 // Mismatch ranges kept per check
+#define MAX_SEGMENTS 16
+
+// Message keys as the phone app sends them (GTTMessageIndex).
+#define PHONE_BATTERY_PERCENT 0
+#define PHONE_BATTERY_CHARGING 1
+#define PHONE_BATTERY_PLUGGED 2
+#define WEATHER_MESSAGE_ICON 4
+#define WEATHER_MESSAGE_TEMPERATURE 5
+#define SIGNAL_STRENGTH_CELL 7
+#define CELL_SERVICE_STATE 9
+#define CONFIG_FEATURES 10
+#define CONFIG_LOW_BATTERY 11
+#define LOW_BATTERY_MODE 12
+#define WEATHER_FORECAST 13
+#define DEBUG_LATENCY 14
+
+// Packed like src/forecast.h describes.
+#define FORECAST_SLOTS 24
+#define FORECAST_ICON_SHIFT 5
+#define FORECAST_DELTA_MASK 0x1F
+
+// Feature bits, and the ones that need data from the phone.
+#define FEATURE_TIMEZONES 0x01
+#define FEATURE_BEATS 0x02
+#define FEATURE_VIBRATE_HOURLY 0x04
+#define FEATURE_WEATHER 0x08
+#define FEATURE_PHONE_BATTERY 0x10
+#define FEATURE_SIGNAL 0x20
+#define FEATURES_ALL 0x3F
+#define FEATURES_PHONE (FEATURE_WEATHER | FEATURE_PHONE_BATTERY | FEATURE_SIGNAL)
+
+// The app, built with -Dmain=gtt_main.
+extern int gtt_main(void);
+extern void do_init(void);
+extern void do_deinit(void);
+extern int compute_beats(struct tm* utc_time);
+
+extern TextLayer* time_text_layer;
+extern TextLayer* time_tz1_text_layer;
+extern TextLayer* time_tz2_text_layer;
+extern TextLayer* time_beats_text_layer;
+extern TextLayer* date_text_layer;
+extern TextLayer* date_dow_layer;
+extern TextLayer* weather_temp_layer;
+extern bool low_battery_mode;
+
+// ---------- Options and state ------------------------------
+
+static int opt_year = 2026;
+static int opt_days = 365;
+static uint32_t opt_seed = 1;
+static int opt_refresh_minutes = 30;
+static const char* opt_trace;
+static uint32_t opt_features_off;
+static int opt_low_battery = -1; // -1 leaves the watch's default
+static int opt_forecast_hours = 6;
+
+// Names for -x.
+static const struct {
+	const char* name;
+	uint32_t bit;
+} feature_names[] = {
+	{ "timezones", FEATURE_TIMEZONES },
+	{ "beats", FEATURE_BEATS },
+	{ "vibe", FEATURE_VIBRATE_HOURLY },
+	{ "weather", FEATURE_WEATHER },
+	{ "phone-battery", FEATURE_PHONE_BATTERY },
+	{ "signal", FEATURE_SIGNAL },
+};
+
+// The latency summary as the phone got it, see latency.h, and the
+// app's histograms at that moment (the request itself gets timed after).
+static uint8_t latency_reply[LATENCY_SUMMARY_SIZE];
+static uint16_t latency_reply_size;
+static LatencyHistogram latency_at_reply[LATENCY_PROBE_COUNT];
+
+// What the watch last said it wants, everything until it says.
+static uint32_t phone_features = FEATURES_PHONE;
+static bool config_sent;
+static bool wide_ints;
+
+#define PHONE_INT(_key, _integer) \
+	(wide_ints ? TupletInteger(_key, (int32_t) (_integer)) : TupletInteger(_key, _integer))
+
+static int64_t start_ms;
+static int64_t end_ms;
+static uint32_t rng;
+
+static int64_t next_tick_ms;
+static int64_t next_bluetooth_ms;
+static int bluetooth_flaps_left;
+static int64_t next_phone_push_ms;
+static int64_t phone_reply_ms = INT64_MAX;
+static int64_t next_hide_ms;
+static int64_t next_show_ms = INT64_MAX;
+static int64_t next_relaunch_ms;
+static int64_t next_forecast_ms;
+
+static double battery_percent = 100.0;
+static int battery_plug_at;
+
+static uint32_t relaunches;
+static uint32_t notifications;
+static uint32_t launch_objects;
+static uint32_t objects_peak;
+
+static uint32_t low_battery_entries;
+static uint32_t low_battery_minutes;
+static int64_t low_battery_since;
+static int64_t low_battery_shortest = INT64_MAX; // Shortest stay in either mode
+static bool was_low_battery;
+
+// ---------- Timezones ------------------------------
+
+typedef struct {
+	const char* rule;
+	time_t hour;
+	int32_t offset;
+} Zone;
+
+static Zone local_zone = { LOCAL_ZONE, -1, 0 };
+static Zone tz1_zone = { TZ1_ZONE, -1, 0 };
+static Zone tz2_zone = { TZ2_ZONE, -1, 0 };
+
+// All these zones change on the hour in UTC, so look them up once an hour.
+static int32_t zone_offset(Zone* z, time_t utc) {
+	time_t hour = utc - (utc % 3600);
+	if (hour != z->hour) {
+		struct tm t;
+		setenv("TZ", z->rule, 1);
+		tzset();
+		localtime_r(&hour, &t);
+		z->hour = hour;
+		z->offset = t.tm_gmtoff;
+	}
+	return z->offset;
+}
+
+static int32_t watch_offset(time_t utc) {
+	return zone_offset(&local_zone, utc);
+}
+
+static void format_local(char* s, size_t slen, time_t local) {
+	struct tm t;
+	gmtime_r(&local, &t);
+	strftime(s, slen, "%Y-%m-%d %H:%M", &t);
+}
+
+// ---------- Reference checks ------------------------------
+
+typedef struct {
+	time_t from;
+	time_t to;
+	char expected[16];
+	char actual[16];
+} MismatchRun;
+
+typedef struct {
+	const char* name;
+	const char* short_name;
+	TextLayer** layer;
+	uint32_t checked;
+	uint32_t wrong;
+	bool in_run;
+	uint32_t run_count;
+	MismatchRun runs[MAX_RUNS];
+} FieldCheck;
+
+typedef enum {
+	CHECK_LOCAL,
+	CHECK_TZ1,
+	CHECK_TZ2,
+	CHECK_BEATS,
+	CHECK_DATE,
+	CHECK_WEEKDAY,
+	CHECK_WEATHER,
+	CHECK_COUNT,
+} CheckIndex;
+
+static FieldCheck checks[CHECK_COUNT] = {
+	{ "local time", "local", &time_text_layer },
+	{ "tz1 (US Pacific)", "tz1", &time_tz1_text_layer },
+	{ "tz2 (Central Europe)", "tz2", &time_tz2_text_layer },
+	{ ".beats", ".beats", &time_beats_text_layer },
+	{ "date", "date", &date_text_layer },
+	{ "weekday", "day", &date_dow_layer },
+	{ "weather temperature", "wthr", &weather_temp_layer },
+};
+
+// Checks known to fail with the app as it is and the default options,
+// and why.  They don't count as problems, so a new failure stands out.
+// The report notes a listed check that passes, so its entry can go
+// with the fix.
+typedef struct {
+	const char* check;
+	const char* reason;
+} ExpectedFailure;
+
+static const ExpectedFailure expected_failures[] = {
+	{ "tz1 (US Pacific)", "fixed offset in draw_time(), wrong across DST changes" },
+	{ "tz2 (Central Europe)", "fixed offset in draw_time(), wrong across DST changes" },
+	{ ".beats", "fixed offset from local time in draw_time()" },
+};
+
+static int expected_count;
+
+// Stretches of the year between DST changes in any of the zones.
+typedef struct {
+	time_t from;
+	int32_t offsets[3];
+	uint32_t checked[CHECK_COUNT];
+	uint32_t wrong[CHECK_COUNT];
+} DstSegment;
+
+static DstSegment segments[MAX_SEGMENTS];
+static uint32_t segment_count;
+
+static uint32_t beats_function_wrong;
+
+static void reference_time(char* s, size_t slen, time_t zone_time) {
+	struct tm t;
+	gmtime_r(&zone_time, &t);
+	if (host_clock_24h) {
+		snprintf(s, slen, "%02d:%02d", t.tm_hour, t.tm_min);
+	}
+	else {
+		int hour = t.tm_hour % 12;
+		snprintf(s, slen, "%d:%02d", (hour == 0 ? 12 : hour), t.tm_min);
+	}
+}
+
+static void reference_beats(char* s, size_t slen, time_t utc) {
+	int seconds = (utc + BEATS_OFFSET) % (24 * 60 * 60);
+	snprintf(s, slen, "@%03d", seconds * 10 / 864);
+}
+
+static void check_field(CheckIndex i, DstSegment* seg, const char* expected, time_t local) {
+	FieldCheck* c = &checks[i];
+	if (*c->layer == NULL) {
+		return;
+	}
+
+	const char* actual = text_layer_get_text(*c->layer);
+	c->checked++;
+	seg->checked[i]++;
+
+	if (strcmp(actual, expected) == 0) {
+		c->in_run = false;
+		return;
+	}
+
+	c->wrong++;
+	seg->wrong[i]++;
+	if (c->in_run) {
+		c->runs[c->run_count - 1].to = local;
+	}
+	else if (c->run_count < MAX_RUNS) {
+		MismatchRun* run = &c->runs[c->run_count++];
+		run->from = run->to = local;
+		snprintf(run->expected, sizeof(run->expected), "%s", expected);
+		snprintf(run->actual, sizeof(run->actual), "%s", actual);
+		c->in_run = true;
+	}
+}
+
+static DstSegment* current_segment(time_t utc, time_t local) {
+	int32_t offsets[3] = {
+		zone_offset(&local_zone, utc),
+		zone_offset(&tz1_zone, utc),
+		zone_offset(&tz2_zone, utc),
+	};
+
+	DstSegment* seg = (segment_count ? &segments[segment_count - 1] : NULL);
+	if ((seg == NULL || memcmp(seg->offsets, offsets, sizeof(offsets)) != 0) &&
+	    segment_count < MAX_SEGMENTS) {
+		seg = &segments[segment_count++];
+		seg->from = local;
+		memcpy(seg->offsets, offsets, sizeof(offsets));
+	}
+	return seg;
+}
+
+static int8_t weather_temp(int hour_of_year);
+
+static void check_time_text(void) {
+	char expected[16];
+	time_t utc = host_now_ms() / 1000;
+	time_t local = host_local_now();
+	DstSegment* seg = current_segment(utc, local);
+
+	reference_time(expected, sizeof(expected), local);
+	check_field(CHECK_LOCAL, seg, expected, local);
+
+	reference_time(expected, sizeof(expected), utc + zone_offset(&tz1_zone, utc));
+	check_field(CHECK_TZ1, seg, expected, local);
+
+	reference_time(expected, sizeof(expected), utc + zone_offset(&tz2_zone, utc));
+	check_field(CHECK_TZ2, seg, expected, local);
+
+	reference_beats(expected, sizeof(expected), utc);
+	check_field(CHECK_BEATS, seg, expected, local);
+
+	struct tm t;
+	gmtime_r(&local, &t);
+	strftime(expected, sizeof(expected), "%Y-%m-%d", &t);
+	check_field(CHECK_DATE, seg, expected, local);
+
+	// The C library only knows English day names.
+	if (strncmp(host_locale, "en", 2) == 0) {
+		strftime(expected, sizeof(expected), "%A", &t);
+		check_field(CHECK_WEEKDAY, seg, expected, local);
+	}
+
+	snprintf(expected, sizeof(expected), "%3d\u00B0C",
+		 weather_temp((host_now_ms() - start_ms) / HOUR_MS));
+	check_field(CHECK_WEATHER, seg, expected, local);
+}
+
+// compute_beats() for every second of a day, against integer math.
+static void check_beats_function(void) {
+	for (int s = 0; s < 24 * 60 * 60; s++) {
+		struct tm t = { .tm_hour = s / 3600, .tm_min = (s / 60) % 60, .tm_sec = s % 60 };
+		if (compute_beats(&t) != s * 10 / 864) {
+			beats_function_wrong++;
+		}
+	}
+}
+
+// ---------- Simulated world ------------------------------
+
+static uint32_t random_next(void) {
+	// xorshift32
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return rng;
+}
+
+static int64_t random_between(int64_t lo, int64_t hi) {
+	return lo + (random_next() % (uint32_t) (hi - lo + 1));
+}
+
+// Cold in January, warm in July, warmest in the afternoon.
+static int8_t weather_temp(int hour_of_year) {
+	int day = (hour_of_year / 24) % 365;
+	int hour = hour_of_year % 24;
+	int season = (day < 182 ? day : 364 - day);
+	return -5 + (season * 30) / 182 + (hour > 6 && hour < 18 ? 4 : -2);
+}
+
+static uint8_t weather_icon(int hour_of_year) {
+	return 1 + (hour_of_year / 3 * 7 + opt_seed) % 4;
+}
+
+static uint16_t pack_forecast(uint8_t* data, int hour_of_year) {
+	int8_t base = weather_temp(hour_of_year);
+	data[0] = ((host_local_now() * SECOND_MS + PHONE_CLOCK_AHEAD_MS) / HOUR_MS) % 24;
+	data[1] = (uint8_t) base;
+	for (int i = 0; i < FORECAST_SLOTS; i++) {
+		int delta = weather_temp(hour_of_year + i) - base;
+		delta = (delta < -16 ? -16 : (delta > 15 ? 15 : delta));
+		data[2 + i] = (weather_icon(hour_of_year + i) << FORECAST_ICON_SHIFT) |
+			(delta & FORECAST_DELTA_MASK);
+	}
+	return 2 + FORECAST_SLOTS;
+}
+
+// The phone's update.  It sends a forecast when the watch asked for
+// data or one is due, and current conditions only with -w 0.
+static void send_phone_state(bool asked) {
+	static uint8_t buffer[256];
+	uint8_t packed[2 + FORECAST_SLOTS];
+	int64_t now = host_now_ms();
+	int hour_of_year = (now - start_ms) / HOUR_MS;
+	int day = hour_of_year / 24;
+	int hour = hour_of_year % 24;
+
+	int8_t temp = weather_temp(hour_of_year);
+	uint8_t icon = weather_icon(hour_of_year);
+	uint8_t phone_percent = 100 - (hour * 3);
+	bool send_forecast = (opt_forecast_hours > 0 && (asked || now >= next_forecast_ms));
+
+	wide_ints = (day % 2 == 1);
+
+	DictionaryIterator iter;
+	dict_write_begin(&iter, buffer, sizeof(buffer));
+	Tuplet battery[] = {
+		PHONE_INT(PHONE_BATTERY_PERCENT, phone_percent),
+		PHONE_INT(PHONE_BATTERY_CHARGING, (uint8_t) (hour < 6)),
+		PHONE_INT(PHONE_BATTERY_PLUGGED, (uint8_t) (hour < 6)),
+	};
+	Tuplet weather[] = {
+		PHONE_INT(WEATHER_MESSAGE_ICON, icon),
+		PHONE_INT(WEATHER_MESSAGE_TEMPERATURE, temp),
+	};
+	Tuplet forecast = TupletBytes(WEATHER_FORECAST, packed, pack_forecast(packed, hour_of_year));
+	Tuplet signal[] = {
+		PHONE_INT(SIGNAL_STRENGTH_CELL, (uint8_t) (1 + day % 4)),
+		PHONE_INT(CELL_SERVICE_STATE, (uint8_t) 1),
+	};
+	Tuplet config = PHONE_INT(CONFIG_FEATURES, (uint32_t) (FEATURES_ALL & ~opt_features_off));
+	Tuplet low_battery = PHONE_INT(CONFIG_LOW_BATTERY, (uint8_t) opt_low_battery);
+
+	if (phone_features & FEATURE_PHONE_BATTERY) {
+		for (unsigned i = 0; i < ARRAY_LENGTH(battery); i++) {
+			dict_write_tuplet(&iter, &battery[i]);
+		}
+	}
+	if ((phone_features & FEATURE_WEATHER) && opt_forecast_hours == 0) {
+		for (unsigned i = 0; i < ARRAY_LENGTH(weather); i++) {
+			dict_write_tuplet(&iter, &weather[i]);
+		}
+	}
+	if ((phone_features & FEATURE_WEATHER) && send_forecast) {
+		dict_write_tuplet(&iter, &forecast);
+		next_forecast_ms = now + opt_forecast_hours * HOUR_MS;
+	}
+	if (phone_features & FEATURE_SIGNAL) {
+		for (unsigned i = 0; i < ARRAY_LENGTH(signal); i++) {
+			dict_write_tuplet(&iter, &signal[i]);
+		}
+	}
+	if (!config_sent) {
+		// The settings from the companion app, with the first update.
+		if (opt_features_off) {
+			dict_write_tuplet(&iter, &config);
+			phone_features = FEATURES_PHONE & ~opt_features_off;
+		}
+		if (opt_low_battery >= 0) {
+			dict_write_tuplet(&iter, &low_battery);
+		}
+		config_sent = true;
+	}
+
+	uint32_t size = dict_write_end(&iter);
+	if (size > 1) {
+		host_deliver_inbox(buffer, size);
+	}
+}
+
+static void phone_outbox_handler(const uint8_t* dict, uint16_t size) {
+	DictionaryIterator iter;
+	dict_read_begin_from_buffer(&iter, dict, size);
+
+	Tuple* latency = dict_find(&iter, DEBUG_LATENCY);
+	if (latency) {
+		latency_reply_size = (latency->length < sizeof(latency_reply) ?
+				      latency->length : sizeof(latency_reply));
+		memcpy(latency_reply, latency->value->data, latency_reply_size);
+		memcpy(latency_at_reply, latency_histograms, sizeof(latency_at_reply));
+		return;
+	}
+
+	Tuple* config = dict_find(&iter, CONFIG_FEATURES);
+	if (config) {
+		phone_features = config->value->uint32 & FEATURES_PHONE;
+	}
+	Tuple* low_battery = dict_find(&iter, LOW_BATTERY_MODE);
+	if (low_battery && low_battery->value->uint8) {
+		// The watch wants nothing until it's out of low battery mode.
+		phone_features = 0;
+	}
+	phone_reply_ms = host_now_ms() + PHONE_REPLY_MS;
+}
+
+static void bluetooth_event(void) {
+	bool connected = !bluetooth_connection_service_peek();
+	int64_t now = host_now_ms();
+
+	host_set_bluetooth(connected);
+
+	// Most drops are one disconnect and a reconnect a while later.
+	// Some are a burst of flapping a few seconds apart.
+	if (bluetooth_flaps_left > 0) {
+		bluetooth_flaps_left--;
+	}
+	if (bluetooth_flaps_left > 0) {
+		next_bluetooth_ms = now + random_between(1, 8) * SECOND_MS;
+	}
+	else if (!connected) {
+		next_bluetooth_ms = now + random_between(10, 1200) * SECOND_MS;
+	}
+	else {
+		next_bluetooth_ms = now + random_between(1, 8) * HOUR_MS;
+		bluetooth_flaps_left = (random_next() % 4 == 0 ? 2 * random_between(2, 5) : 0);
+	}
+}
+
+// Runs once a minute with the tick.  Pebble reports 10% steps.
+static void battery_step(void) {
+	BatteryChargeState old = battery_state_service_peek();
+	BatteryChargeState state = old;
+
+	if (old.is_plugged) {
+		battery_percent += 40.0 / 60;
+		if (battery_percent >= 100) {
+			battery_percent = 100;
+			state.is_charging = false;
+			state.is_plugged = false;
+			battery_plug_at = random_between(5, 30);
+		}
+	}
+	else {
+		battery_percent -= 0.55 / 60;
+		if (battery_percent <= battery_plug_at) {
+			state.is_charging = true;
+			state.is_plugged = true;
+		}
+	}
+
+	state.charge_percent = ((int) battery_percent) / 10 * 10;
+	if (state.charge_percent != old.charge_percent ||
+	    state.is_charging != old.is_charging ||
+	    state.is_plugged != old.is_plugged) {
+		host_set_battery(state);
+	}
+}
+
+// Runs once a minute, after the battery step.
+static void note_battery_mode(void) {
+	int64_t now = host_now_ms();
+	if (low_battery_mode != was_low_battery) {
+		if (now - low_battery_since < low_battery_shortest) {
+			low_battery_shortest = now - low_battery_since;
+		}
+		low_battery_since = now;
+		low_battery_entries += low_battery_mode;
+		was_low_battery = low_battery_mode;
+	}
+	low_battery_minutes += low_battery_mode;
+}
+
+static void note_objects(void) {
+	uint32_t live = host_objects_live();
+	if (live > objects_peak) {
+		objects_peak = live;
+	}
+}
+
+static void relaunch(void) {
+	// Leaving the watchface for an app and coming back.  Two events,
+	// like on the watch, so the new launch loading the same bitmaps
+	// the old one freed isn't counted as reloading them.
+	host_begin_event("window", 0);
+	host_stats.window_events++;
+	do_deinit();
+	host_end_event();
+
+	host_begin_event("launch", 0);
+	host_stats.window_events++;
+	do_init();
+	host_end_event();
+	relaunches++;
+}
+
+static int64_t min_ms(int64_t a, int64_t b) {
+	return (a < b ? a : b);
+}
+
+static void run_year(void) {
+	next_tick_ms = start_ms + MINUTE_MS;
+	low_battery_since = start_ms;
+	was_low_battery = low_battery_mode;
+	next_bluetooth_ms = start_ms + random_between(1, 8) * HOUR_MS;
+	next_phone_push_ms = start_ms + opt_refresh_minutes * MINUTE_MS;
+	next_hide_ms = start_ms + random_between(1, 6) * HOUR_MS;
+	next_relaunch_ms = start_ms + random_between(1, 24) * HOUR_MS;
+	battery_plug_at = random_between(5, 30);
+
+	while (true) {
+		int64_t next = next_tick_ms;
+		next = min_ms(next, host_next_timer_ms());
+		next = min_ms(next, next_bluetooth_ms);
+		next = min_ms(next, next_phone_push_ms);
+		next = min_ms(next, phone_reply_ms);
+		next = min_ms(next, next_hide_ms);
+		next = min_ms(next, next_show_ms);
+		next = min_ms(next, next_relaunch_ms);
+		if (next >= end_ms) {
+			break;
+		}
+		host_set_now_ms(next);
+
+		if (next == next_tick_ms) {
+			host_deliver_tick();
+			check_time_text();
+			battery_step();
+			note_battery_mode();
+			next_tick_ms += MINUTE_MS;
+		}
+		if (next >= host_next_timer_ms()) {
+			host_fire_due_timers();
+		}
+		if (next == next_bluetooth_ms) {
+			bluetooth_event();
+		}
+		if (next == phone_reply_ms) {
+			phone_reply_ms = INT64_MAX;
+			if (bluetooth_connection_service_peek()) {
+				send_phone_state(true);
+			}
+		}
+		if (next == next_phone_push_ms) {
+			next_phone_push_ms += opt_refresh_minutes * MINUTE_MS;
+			if (bluetooth_connection_service_peek() && phone_features) {
+				send_phone_state(false);
+			}
+		}
+		if (next == next_hide_ms) {
+			// A notification covers the face for a bit.
+			host_begin_event("window", 0);
+			host_stats.window_events++;
+			host_window_disappear();
+			host_end_event();
+			next_show_ms = next + random_between(3, 30) * SECOND_MS;
+			next_hide_ms = next + random_between(1, 6) * HOUR_MS;
+			notifications++;
+		}
+		if (next == next_show_ms) {
+			host_begin_event("window", 0);
+			host_stats.window_events++;
+			host_window_appear();
+			host_end_event();
+			next_show_ms = INT64_MAX;
+		}
+		if (next == next_relaunch_ms) {
+			relaunch();
+			next_relaunch_ms = next + random_between(12, 36) * HOUR_MS;
+		}
+
+		note_objects();
+	}
+}
+
+// What the phone does to get the latency summary.
+static void request_latency_summary(void) {
+	uint8_t buffer[16];
+	DictionaryIterator iter;
+	Tuplet request = TupletInteger(DEBUG_LATENCY, (uint8_t) 1);
+
+	if (!bluetooth_connection_service_peek()) {
+		host_set_bluetooth(true);
+	}
+	dict_write_begin(&iter, buffer, sizeof(buffer));
+	dict_write_tuplet(&iter, &request);
+	host_deliver_inbox(buffer, dict_write_end(&iter));
+}
+
+// The app's main() calls this after do_init().
+void app_event_loop(void) {
+	host_end_event();
+	launch_objects = host_objects_live();
+	objects_peak = launch_objects;
+
+	run_year();
+	request_latency_summary();
+}
+
+// ---------- Report ------------------------------
+
+// Whether a check's result counts as a problem, see expected_failures.
+static int problem(const char* check, bool failed) {
+	for (unsigned i = 0; i < ARRAY_LENGTH(expected_failures); i++) {
+		if (strcmp(expected_failures[i].check, check) == 0) {
+			if (failed) {
+				printf("    expected: %s\n", expected_failures[i].reason);
+				expected_count++;
+				return 0;
+			}
+			printf("    passes, but listed as expected to fail\n");
+			return 0;
+		}
+	}
+	return failed;
+}
+
+static int report_field(FieldCheck* c) {
+	printf("  %-22s %6u of %6u minutes wrong\n", c->name, c->wrong, c->checked);
+	for (uint32_t i = 0; i < c->run_count; i++) {
+		char from[32];
+		char to[32];
+		format_local(from, sizeof(from), c->runs[i].from);
+		format_local(to, sizeof(to), c->runs[i].to);
+		printf("    %s .. %s  shows \"%s\", expected \"%s\"\n",
+		       from, to, c->runs[i].actual, c->runs[i].expected);
+	}
+	if (c->wrong > 0 && c->run_count == MAX_RUNS) {
+		printf("    (more not shown)\n");
+	}
+	return problem(c->name, c->wrong > 0);
+}
+
+static uint32_t read_le(const uint8_t* p, int bytes) {
+	uint32_t value = 0;
+	for (int i = bytes - 1; i >= 0; i--) {
+		value = (value << 8) | p[i];
+	}
+	return value;
+}
+
+// The app's histograms, and whether the phone's summary matches them.
+static int report_latency(void) {
+	printf("\nLatency (ms)%s\n", (host_cpu_scale > 0 ? "" : ", simulated clock only (see -c)"));
+	printf("  %-20s %9s", "", "calls");
+	for (int b = 0; b < LATENCY_BUCKETS; b++) {
+		char label[8];
+		if (b < LATENCY_BUCKETS - 1) {
+			snprintf(label, sizeof(label), "<%d", latency_bucket_limit_ms(b));
+		}
+		else {
+			snprintf(label, sizeof(label), ">=%d", latency_bucket_limit_ms(b - 1));
+		}
+		printf("  %7s", label);
+	}
+	printf(" %6s %4s %4s\n", "max", "p50", "p95");
+
+	bool reply_ok = (latency_reply_size == LATENCY_SUMMARY_SIZE &&
+			 latency_reply[0] == LATENCY_PROBE_COUNT);
+	for (int i = 0; i < LATENCY_PROBE_COUNT; i++) {
+		LatencyHistogram* h = &latency_histograms[i];
+		printf("  %-20s %9u", latency_probe_name(i), h->calls);
+		for (int b = 0; b < LATENCY_BUCKETS; b++) {
+			printf("  %7u", h->buckets[b]);
+		}
+		printf(" %6u %4u %4u\n", h->max_ms,
+		       latency_percentile_ms(h, 50), latency_percentile_ms(h, 95));
+
+		const uint8_t* p = &latency_reply[1 + i * LATENCY_PROBE_SUMMARY_SIZE];
+		const LatencyHistogram* sent = &latency_at_reply[i];
+		if (reply_ok &&
+		    (read_le(p, 4) != sent->calls || read_le(p + 4, 2) != sent->max_ms ||
+		     p[6] != latency_percentile_ms(sent, 50) || p[7] != latency_percentile_ms(sent, 95))) {
+			reply_ok = false;
+		}
+	}
+
+	if (reply_ok) {
+		printf("  Summary sent to the phone matches (%u bytes)\n", latency_reply_size);
+	}
+	else {
+		printf("  Summary sent to the phone is missing or doesn't match (%u bytes)\n",
+		       latency_reply_size);
+	}
+	return problem("latency summary", !reply_ok);
+}
+
+static void report_segments(void) {
+	printf("\n  %% of minutes wrong between DST changes\n");
+	printf("                          ");
+	for (int c = 0; c < CHECK_COUNT; c++) {
+		printf(" %6s", checks[c].short_name);
+	}
+	printf("\n");
+	for (uint32_t i = 0; i < segment_count; i++) {
+		DstSegment* seg = &segments[i];
+		char from[32];
+		format_local(from, sizeof(from), seg->from);
+		printf("    from %s", from);
+		for (int c = 0; c < CHECK_COUNT; c++) {
+			if (seg->checked[c] == 0) {
+				printf("      -");
+			}
+			else {
+				printf(" %6.1f", 100.0 * seg->wrong[c] / seg->checked[c]);
+			}
+		}
+		printf("\n");
+	}
+}
+
+static int report(void) {
+	int problems = 0;
+	double days = (double) (end_ms - start_ms) / DAY_MS;
+	HostStats* s = &host_stats;
+
+	printf("GotTheTime host simulation: %d days from %d-01-01, seed %u, %s clock\n",
+	       opt_days, opt_year, opt_seed, (host_clock_24h ? "24h" : "12h"));
+	if (opt_features_off) {
+		printf("  features 0x%02x turned off from the phone\n", opt_features_off);
+	}
+	printf("  %u relaunches, %u notifications\n\n", relaunches, notifications);
+
+	printf("Wakeups: %u (%.0f/day)\n", s->wakeups, s->wakeups / days);
+	printf("  ticks %u, timers %u, bluetooth %u, battery %u, inbox %u, window %u\n",
+	       s->ticks, s->timers_fired, s->bluetooth_events, s->battery_events,
+	       s->inbox_messages, s->window_events);
+	printf("Redraw: %u frames, %u layer redraws, %llu pixels (%.0f/day), %u text updates\n",
+	       s->frames, s->layer_redraws, (unsigned long long) s->redraw_area,
+	       s->redraw_area / days, s->text_updates);
+	printf("Vibes: %u, %u ms on\n", s->vibes, s->vibe_ms);
+	printf("AppMessage: %u sent, %llu bytes out, %llu bytes in, %u dropped, %u sync errors\n",
+	       s->outbox_messages, (unsigned long long) s->outbox_bytes,
+	       (unsigned long long) s->inbox_bytes, s->inbox_dropped, s->sync_errors);
+	problems += problem("sync errors", s->sync_errors > 0);
+	printf("Persistent storage: %u writes\n", s->persist_writes);
+	printf("Low battery mode: %u times, %.1f days of %.1f",
+	       low_battery_entries, low_battery_minutes / (24.0 * 60), days);
+	if (low_battery_shortest != INT64_MAX) {
+		printf(", shortest stay in a mode %.1f h", (double) low_battery_shortest / HOUR_MS);
+	}
+	printf("\n\n");
+
+	printf("Leak checks\n");
+	printf("  app_sync_init while active: %u (%u inits, %u deinits)\n",
+	       s->sync_reinits, s->sync_inits, s->sync_deinits);
+	problems += problem("app_sync_init while active", s->sync_reinits > 0);
+	printf("  timers stacked on a pending twin: %u (peak %u pending)\n",
+	       s->stacked_timers, s->timers_peak);
+	problems += problem("timers stacked on a pending twin", s->stacked_timers > 0);
+	printf("  bitmaps reloaded in one event: %u of %u created\n",
+	       s->bitmap_churn, s->bitmap_creates);
+	problems += problem("bitmaps reloaded in one event", s->bitmap_churn > 0);
+	printf("  objects: %u after launch, peak %u, %u live at exit\n",
+	       launch_objects, objects_peak, host_objects_live());
+	for (int i = 0; i < HOST_OBJ_COUNT; i++) {
+		if (s->live[i] > 0) {
+			printf("    %u %s still live\n", s->live[i], host_object_names[i]);
+		}
+	}
+	problems += problem("objects", objects_peak > launch_objects || host_objects_live() > 0);
+
+	problems += report_latency();
+
+	printf("\nTime checks\n");
+	printf("  compute_beats()        %6u of  86400 seconds wrong\n", beats_function_wrong);
+	problems += problem("compute_beats()", beats_function_wrong > 0);
+	for (int i = 0; i < CHECK_COUNT; i++) {
+		problems += report_field(&checks[i]);
+	}
+	report_segments();
+
+	printf("\n%s (%d problem%s, %d expected failure%s)\n", (problems ? "FAIL" : "OK"),
+	       problems, (problems == 1 ? "" : "s"), expected_count, (expected_count == 1 ? "" : "s"));
+	return problems;
+}
+
+static void usage(const char* name) {
+	fprintf(stderr, "Usage: %s [-y year] [-d days] [-s seed] [-r refresh_minutes] [-2] [-v]\n"
+		"       [-t trace_file] [-x features] [-b percent] [-l locale]\n"
+		"       [-w forecast_hours] [-c cpu_scale]\n", name);
+	exit(2);
+}
+
+// Feature bits from a list like "beats,timezones", false if a name
+// isn't known.
+static bool parse_features(const char* list, uint32_t* bits) {
+	char copy[128];
+	snprintf(copy, sizeof(copy), "%s", list);
+
+	*bits = 0;
+	for (char* name = strtok(copy, ","); name != NULL; name = strtok(NULL, ",")) {
+		bool all = (strcmp(name, "all") == 0);
+		bool found = all;
+		for (unsigned i = 0; i < ARRAY_LENGTH(feature_names); i++) {
+			if (all || strcmp(name, feature_names[i].name) == 0) {
+				*bits |= feature_names[i].bit;
+				found = true;
+			}
+		}
+		if (!found) {
+			fprintf(stderr, "Unknown feature \"%s\"\n", name);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	int opt;
+	while ((opt = getopt(argc, argv, "y:d:s:r:2vt:x:b:l:w:c:")) != -1) {
+		switch (opt) {
+		case 'y': opt_year = atoi(optarg); break;
+		case 'd': opt_days = atoi(optarg); break;
+		case 's': opt_seed = strtoul(optarg, NULL, 10); break;
+		case 'r': opt_refresh_minutes = atoi(optarg); break;
+		case '2': host_clock_24h = true; break;
+		case 'v': host_log_level = APP_LOG_LEVEL_DEBUG; break;
+		case 't': opt_trace = optarg; break;
+		case 'x':
+			if (!parse_features(optarg, &opt_features_off)) {
+				usage(argv[0]);
+			}
+			break;
+		case 'l': host_locale = optarg; break;
+		case 'b': opt_low_battery = atoi(optarg); break;
+		case 'w': opt_forecast_hours = atoi(optarg); break;
+		case 'c': host_cpu_scale = atof(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (opt_days < 1 || opt_refresh_minutes < 1) {
+		usage(argv[0]);
+	}
+
+	rng = (opt_seed ? opt_seed : 1);
+
+	// Start at local midnight on January 1st.
+	struct tm jan1 = { .tm_year = opt_year - 1900, .tm_mday = 1 };
+	time_t start = timegm(&jan1);
+	start -= watch_offset(start);
+	start_ms = start * SECOND_MS;
+	end_ms = start_ms + opt_days * DAY_MS;
+
+	host_set_offset_function(watch_offset);
+	host_set_outbox_handler(phone_outbox_handler);
+	host_set_now_ms(start_ms);
+
+	FILE* trace = NULL;
+	if (opt_trace) {
+		trace = fopen(opt_trace, "w");
+		if (trace == NULL) {
+			perror(opt_trace);
+			return 2;
+		}
+		host_trace_open(trace);
+		fprintf(trace, "# span_ms,%lld,%lld\n", (long long) start_ms, (long long) end_ms);
+		fprintf(trace, "# refresh_minutes,%d\n", opt_refresh_minutes);
+		fprintf(trace, "# features_off,0x%02x\n", opt_features_off);
+	}
+
+	check_beats_function();
+
+	host_begin_event("launch", 0);
+	gtt_main();
+
+	int problems = report();
+	if (trace) {
+		fclose(trace);
+	}
+	return (problems ? 1 : 0);
+}
@@ -13,14 +13,27 @@ Used "Simplicity" watchface as a guide, but I want the day of the week.
 | sun    10d | <<< weather
 +------------+
 
+The weather steps through an hourly forecast from the phone when it
+has one, so a single message covers many hours.
+
 - Vibrate on the hour, when enabled.  (Enabled by default.)
 - Vibrate and display graphic when Bluetooth disconnected.
+- Time zones, .beats, weather, phone battery, signal and the hourly
+  vibe can each be turned off from the companion app on the phone.
+  Turned off features don't keep any layers or ask the phone for data.
+- When the watch battery runs low, only the time and date are shown,
+  the phone is told not to send anything and the hourly vibe is off
+  until the watch is plugged in.  The threshold is a setting too.
 
 */
 
 #include <pebble.h>
 #include <time.h>
 
+#include "forecast.h"
+#include "latency.h"
+#include "time_format.h"
+
 // ---------- Screen Locations ------------------------------
 // These are all relative to the base window.
 // Individual layers are relative to their parent layer.
@@ -72,7 +85,41 @@ Used "Simplicity" watchface as a guide, but I want the day of the week.
 
 // ---------- Options and vibes ------------------------------
 
-#define VIBRATE_HOURLY 1 // Change to 0 to disable
+// Features that can be turned on and off from the phone.
+typedef enum {
+	FEATURE_TIMEZONES = 1 << 0,      // The two extra timezones under the time
+	FEATURE_BEATS = 1 << 1,          // Swatch .beats under the time
+	FEATURE_VIBRATE_HOURLY = 1 << 2,
+	FEATURE_WEATHER = 1 << 3,
+	FEATURE_PHONE_BATTERY = 1 << 4,
+	FEATURE_SIGNAL = 1 << 5,
+} Feature;
+
+#define FEATURES_ALL 0x3F
+#define FEATURES_PHONE (FEATURE_WEATHER | FEATURE_PHONE_BATTERY | FEATURE_SIGNAL) // Need the phone app
+
+// Until the phone sends settings.  Can be set from the compiler
+// command line (-DFEATURES_DEFAULT=0x3B).
+#ifndef FEATURES_DEFAULT
+#define FEATURES_DEFAULT FEATURES_ALL
+#endif
+
+// Low battery mode turns everything above off at this watch battery
+// percent, until the watch is plugged in or the reading climbs back
+// past the threshold plus the hysteresis.  0 turns it off.
+#ifndef LOW_BATTERY_PERCENT_DEFAULT
+#define LOW_BATTERY_PERCENT_DEFAULT 20
+#endif
+#define LOW_BATTERY_HYSTERESIS 10 // The watch reports in 10% steps
+
+// Persistent storage keys
+#define PERSIST_KEY_FEATURES 1
+#define PERSIST_KEY_LOW_BATTERY 2
+#define PERSIST_KEY_MODE_TIMES 3
+#define PERSIST_KEY_FORECAST 4
+
+// Ask the phone for a new forecast when this many hours are left.
+#define FORECAST_REFRESH_SLOTS 2
 
 // After losing bluetooth, the wait before the vibe/display is sent.
 // This should stop it from alerting on very short drops in bluetooth.
@@ -103,6 +150,12 @@ typedef enum {
 	SIGNAL_STRENGTH_CELL = 7, // TUPLE_UINT
 	SIGNAL_STRENGTH_WIFI = 8, // TUPLE_UINT
 	CELL_SERVICE_STATE = 9, // TUPLE_UINT
+	CONFIG_FEATURES = 10, // TUPLE_UINT, Feature bits, both ways
+	CONFIG_LOW_BATTERY = 11, // TUPLE_UINT, percent, 0 for never
+	LOW_BATTERY_MODE = 12, // TUPLE_UINT, 1 while the watch wants nothing, watch to phone
+	WEATHER_FORECAST = 13, // TUPLE_BYTE_ARRAY, see forecast.h
+	DEBUG_LATENCY = 14, // TUPLE_UINT from the phone: 1 for a summary, 2 to also reset
+	                    // TUPLE_BYTE_ARRAY back, see latency.h
 } GTTMessageIndex; // GotTheTime App Message indexes
 
 // Weather Icon codes are here:
@@ -128,21 +181,50 @@ static uint32_t WEATHER_ICONS[] = {
 	RESOURCE_ID_IMAGE_WEATHER_CLOUD,
 };
 
-#define INBOUND_MESSAGE_SIZE 128
+// Sized for the worst case of the keys in phone_sync_start(): any
+// companion app may send every integer 4 bytes wide, plus a full
+// forecast.  Each tuple has a 7 byte header and the dictionary a 1 byte
+// count.
+#define SYNC_TUPLE_HEADER_SIZE 7
+#define SYNC_INTEGER_KEYS 10
+#define SYNC_BUFFER_SIZE (1 + (SYNC_INTEGER_KEYS + 1) * SYNC_TUPLE_HEADER_SIZE + \
+			  SYNC_INTEGER_KEYS * sizeof(uint32_t) + FORECAST_PACKED_MAX)
+
+// The phone never sends more than the keys it syncs.
+#define INBOUND_MESSAGE_SIZE SYNC_BUFFER_SIZE
 #define OUTBOUND_MESSAGE_SIZE 128
 
 // For getting information from the companion app on the phone.
 AppSync sync;
-uint8_t sync_buffer[128];
+uint8_t sync_buffer[SYNC_BUFFER_SIZE];
+bool sync_running;
 
 typedef struct {
 	uint8_t icon;
 	int32_t temp;
 } WeatherInfo;
 
+// Settings
+uint32_t features;        // What the settings turn on
+uint32_t features_loaded; // What has its layers loaded right now
+uint8_t low_battery_percent;
+
+// Low battery mode, and the seconds spent in each mode across launches.
+typedef struct {
+	uint32_t normal;
+	uint32_t low;
+} ModeTimes;
+
+bool low_battery_mode;
+ModeTimes mode_times;
+time_t mode_since;
+
 // Last known state
 BatteryChargeState phone_battery_state;
-WeatherInfo weather_info;
+WeatherInfo weather_info; // Current conditions, when there's no forecast
+Forecast forecast;
+uint8_t forecast_packed[FORECAST_PACKED_MAX]; // As last received, for the AppSync
+uint8_t forecast_packed_size;
 uint signal_level_cell;
 uint cell_service_state;
 
@@ -169,6 +251,8 @@ Layer* weather_layer; // Weather info
 BitmapLayer* weather_cond_layer;
 GBitmap* weather_cond_bitmap;
 TextLayer* weather_temp_layer;
+uint8_t weather_shown_icon;
+int32_t weather_shown_temp;
 
 Layer* signal_layer; // Signal strength info
 TextLayer* signal_strength_layer;
@@ -176,75 +260,60 @@ TextLayer* signal_strength_layer;
 GFont font_21;
 GFont font_49_numbers;
 
+// Text shown in the layers above, rewritten in place as time passes.
+static DateText date_text;
+static TimeText time_text;
+static TimeText tz1_text;
+static TimeText tz2_text;
+static BeatsText beats_text;
+
 // ---------- Drawing functions ------------------------------
 
 void draw_dayofweek(struct tm* ptime) {
-	static char day_text[]  = "Xxxxxxxxxx"; // Wednesday
-
 	// Day of the week, full name
-	strftime(day_text, sizeof(day_text), "%A", ptime);
-	text_layer_set_text(date_dow_layer, day_text);
+	text_layer_set_text(date_dow_layer, weekday_name(ptime->tm_wday));
 }
 
 void draw_date(struct tm* ptime) {
-	static char date_text[] = "0000-00-00"; // 2013-10-02
-
-	// Date
-	strftime(date_text, sizeof(date_text), "%Y-%m-%d", ptime);
-	text_layer_set_text(date_text_layer, date_text);
-}
-
-void draw_one_time(struct tm* ptime, char* s, const uint8_t slen, TextLayer* tlayer) {
-	char* time_format = NULL;
-
-	// Time, not including seconds
-	if (clock_is_24h_style()) {
-		time_format = "%R";
-	} else {
-		// This includes a leading zero.
-		// The format without a leading zero ("%l")
-		// includes a leading space.  We want neither,
-		// so remove the zero after formatting the text.
-		time_format = "%I:%M";
+	// Date, 2013-10-02
+	if (date_text_update(&date_text, ptime)) {
+		text_layer_set_text(date_text_layer, date_text.text);
 	}
-	strftime(s, slen, time_format, ptime);
+}
 
-	// Hack to remove a leading zero or space for 12-hour times.
-	if (!clock_is_24h_style()) {
-		memmove(s, &s[1], slen - 1);
+void draw_one_time(struct tm* ptime, TimeText* tt, TextLayer* tlayer) {
+	// Time, not including seconds, and no leading zero for 12-hour times.
+	if (time_text_update(tt, ptime, clock_is_24h_style())) {
+		text_layer_set_text(tlayer, tt->text);
 	}
-
-	text_layer_set_text(tlayer, s);
 }
 
 int compute_beats(struct tm* utc_time) {
-	// This is the floor, not rounded down.  Not yet sure if it matters.
-	return ((utc_time->tm_sec + (utc_time->tm_min * 60) +
-		 (utc_time->tm_hour * 3600)) / 86.4);
+	// A beat is 86.4 seconds.  This is the floor, not rounded.
+	int seconds = utc_time->tm_sec + (utc_time->tm_min * 60) +
+		(utc_time->tm_hour * 3600);
+	return (seconds * 10) / 864;
 }
 
-void draw_beats_time(struct tm* utc_time, char* s, const uint8_t slen, TextLayer* tlayer) {
-	int beats = compute_beats(utc_time);
-
-	snprintf(s, slen, "@%03d", beats);
-
-	text_layer_set_text(tlayer, s);
+void draw_beats_time(struct tm* utc_time, BeatsText* bt, TextLayer* tlayer) {
+	if (beats_text_update(bt, compute_beats(utc_time))) {
+		text_layer_set_text(tlayer, bt->text);
+	}
 }
 
 void draw_time(struct tm* ptime) {
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s", __FUNCTION__);
 
-	static char time_text[] = "00:00";
-	static char tz1_text[]  = "00:00";
-	static char tz2_text[]  = "00:00";
-	static char beats_text[]= "@000";
-
 	// Although this makes it different from the other "per line"
 	// drawing functions, the time is all related, so update all
 	// the time lines in the same function.
 
 	// Local time
-	draw_one_time(ptime, time_text, sizeof(time_text), time_text_layer);
+	draw_one_time(ptime, &time_text, time_text_layer);
+
+	if (!(features_loaded & (FEATURE_TIMEZONES | FEATURE_BEATS))) {
+		return;
+	}
 
 	// XXX Since there's no good way to get UTC time from the watch
 	//     we have to fake other timezones.  This will break if I
@@ -252,25 +321,25 @@ void draw_time(struct tm* ptime) {
 	time_t tz_t;
 	time(&tz_t);  // This is local to the current timezone.
 
-	// Additional time zone 1
-	time_t tz1_t = tz_t + (-3 * 60 * 60); // Pacific relative to my timezone
-	struct tm* tz1_time = gmtime(&tz1_t);
-	draw_one_time(tz1_time, tz1_text, sizeof(tz1_text), time_tz1_text_layer);
-
-	// Additional time zone 2
-	time_t tz2_t = tz_t + (+6 * 60 * 60);
-	struct tm* tz2_time = gmtime(&tz2_t); // Central Europe relative to my timezone
-	draw_one_time(tz2_time, tz2_text, sizeof(tz2_text), time_tz2_text_layer);
+	if (features_loaded & FEATURE_TIMEZONES) {
+		// Additional time zone 1
+		time_t tz1_t = tz_t + (-3 * 60 * 60); // Pacific relative to my timezone
+		struct tm* tz1_time = gmtime(&tz1_t);
+		draw_one_time(tz1_time, &tz1_text, time_tz1_text_layer);
 
-	// Beats time
-	// No daylight savings time in .beats.  It's normally UTC+1 that's the
-	// basis for .beats, but we're in DST now, so it should just be UTC.
-	time_t utc_t = tz_t + (+5 * 60 * 60);
-	struct tm* utc_time = gmtime(&utc_t);
-	draw_beats_time(utc_time, beats_text, sizeof(beats_text), time_beats_text_layer);
+		// Additional time zone 2
+		time_t tz2_t = tz_t + (+6 * 60 * 60);
+		struct tm* tz2_time = gmtime(&tz2_t); // Central Europe relative to my timezone
+		draw_one_time(tz2_time, &tz2_text, time_tz2_text_layer);
+	}
 
-	if (VIBRATE_HOURLY && (ptime->tm_min == 0)) {
-		vibes_enqueue_custom_pattern(HOUR_VIBE_PATTERN);
+	if (features_loaded & FEATURE_BEATS) {
+		// Beats time
+		// No daylight savings time in .beats.  It's normally UTC+1 that's the
+		// basis for .beats, but we're in DST now, so it should just be UTC.
+		time_t utc_t = tz_t + (+5 * 60 * 60);
+		struct tm* utc_time = gmtime(&utc_t);
+		draw_beats_time(utc_time, &beats_text, time_beats_text_layer);
 	}
 }
 
@@ -312,27 +381,45 @@ void draw_battery_common(Layer* layer, GContext* ctx, BatteryChargeState batt) {
 }
 
 void draw_battery_watch_callback(Layer* layer, GContext* ctx) {
+	uint32_t start = latency_start();
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s", __FUNCTION__);
 	draw_battery_common(layer, ctx, battery_state_service_peek());
+	latency_end(LATENCY_DRAW_WATCH_BATTERY, start);
 }
 
 void draw_battery_phone_callback(Layer* layer, GContext* ctx) {
+	uint32_t start = latency_start();
 	draw_battery_common(layer, ctx, phone_battery_state);
+	latency_end(LATENCY_DRAW_PHONE_BATTERY, start);
+}
+
+// The forecast for this hour, or the last current conditions without one.
+WeatherInfo weather_now(void) {
+	const ForecastSlot* slot = forecast_slot(&forecast, time(NULL));
+	if (slot) {
+		return (WeatherInfo) { .icon = slot->icon, .temp = slot->temp };
+	}
+	return weather_info;
 }
 
 void draw_weather(WeatherInfo winfo) {
 	static char temperature_text[] = "000 %C"; // temperature, 2 spaces for unicode degree sign
 
-	snprintf(temperature_text, sizeof(temperature_text), "%3d\u00B0C", (int) winfo.temp);
-	text_layer_set_text(weather_temp_layer, temperature_text);
+	if (winfo.temp != weather_shown_temp) {
+		snprintf(temperature_text, sizeof(temperature_text), "%3d\u00B0C", (int) winfo.temp);
+		text_layer_set_text(weather_temp_layer, temperature_text);
+		weather_shown_temp = winfo.temp;
+	}
 
 	// If we didn't get an icon, just leave it unchanged.
-	if (winfo.icon > 0) {
+	if (winfo.icon > 0 && winfo.icon < ARRAY_LENGTH(WEATHER_ICONS) &&
+	    winfo.icon != weather_shown_icon) {
 		if (weather_cond_bitmap) {
 			gbitmap_destroy(weather_cond_bitmap);
 		}
 		weather_cond_bitmap = gbitmap_create_with_resource(WEATHER_ICONS[winfo.icon]);
 		bitmap_layer_set_bitmap(weather_cond_layer, weather_cond_bitmap);
+		weather_shown_icon = winfo.icon;
 	}
 }
 
@@ -355,6 +442,11 @@ void draw_signals(uint level, uint service_state) {
 
 // ---------- Message functions ------------------------------
 
+// What's running: the settings, unless the battery is low.
+static uint32_t active_features(void) {
+	return (low_battery_mode ? 0 : features);
+}
+
 static void sync_error_callback(DictionaryResult dict_err, AppMessageResult app_msg_err, void* context) {
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s %d", __FUNCTION__, app_msg_err);
 
@@ -381,9 +473,13 @@ static void sync_error_callback(DictionaryResult dict_err, AppMessageResult app_
 }
 
 static void send_message(void) {
-	// Empty message to send, just to trigger the JS/phone to do something.
+	// Message to trigger the JS/phone to do something.
+	// It also sends the settings, and whether low battery mode
+	// means the phone shouldn't send anything right now.
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s", __FUNCTION__);
 	Tuplet value = TupletInteger(1, 1);
+	Tuplet config = TupletInteger(CONFIG_FEATURES, features);
+	Tuplet low_battery = TupletInteger(LOW_BATTERY_MODE, (uint8_t) low_battery_mode);
 
 	DictionaryIterator *iter;
 	AppMessageResult res = app_message_outbox_begin(&iter);
@@ -396,20 +492,60 @@ static void send_message(void) {
 	}
 
 	dict_write_tuplet(iter, &value);
+	dict_write_tuplet(iter, &config);
+	dict_write_tuplet(iter, &low_battery);
 	dict_write_end(iter);
 
 	app_message_outbox_send();
 }
 
+static void send_latency_summary(bool reset) {
+	uint8_t summary[LATENCY_SUMMARY_SIZE];
+	uint16_t size = latency_summary(summary, sizeof(summary));
+
+	DictionaryIterator *iter;
+	AppMessageResult res = app_message_outbox_begin(&iter);
+	if (res != APP_MSG_OK || iter == NULL) {
+		sync_error_callback(DICT_OK, res, NULL);
+		return;
+	}
+
+	Tuplet value = TupletBytes(DEBUG_LATENCY, summary, size);
+	dict_write_tuplet(iter, &value);
+	dict_write_end(iter);
+	app_message_outbox_send();
+
+	if (reset) {
+		latency_reset();
+	}
+}
+
+static AppTimer* send_message_timer;
+
 static void send_message_callback(void* ignored) {
+	uint32_t start = latency_start();
+	send_message_timer = NULL;
 	send_message();
+	latency_end(LATENCY_SEND_MESSAGE_TIMER, start);
+}
+
+// Ask the phone for fresh data, unless nothing wants it.
+static void request_phone_update(uint32_t delay_ms) {
+	if (!(active_features() & FEATURES_PHONE) || send_message_timer) {
+		return;
+	}
+	send_message_timer = app_timer_register(delay_ms, send_message_callback, NULL);
 }
 
+static void features_apply(uint32_t old_active);
+static void low_battery_check(BatteryChargeState charge);
+
 static void sync_tuple_changed_callback(const uint32_t key,
 					const Tuple* new_values,
 					const Tuple* old_values,
 					void* context)
 {
+	uint32_t start = latency_start();
 	bool update_battery = false;
 	bool update_weather = false;
 	bool update_signals = false;
@@ -458,6 +594,27 @@ static void sync_tuple_changed_callback(const uint32_t key,
 			update_weather = true;
 		}
 		break;
+	case WEATHER_FORECAST:
+		if (new_values && new_values->length > 0 &&
+		    new_values->length <= sizeof(forecast_packed) &&
+		    (new_values->length != forecast_packed_size ||
+		     memcmp(new_values->value->data, forecast_packed, forecast_packed_size) != 0)) {
+			memcpy(forecast_packed, new_values->value->data, new_values->length);
+			forecast_packed_size = new_values->length;
+			forecast_decode(&forecast, forecast_packed, forecast_packed_size, time(NULL));
+			APP_LOG(APP_LOG_LEVEL_DEBUG, "%s WEATHER_FORECAST: %d hours",
+				__FUNCTION__, forecast.count);
+			// Keep it through relaunches, it's good for hours.
+			persist_write_data(PERSIST_KEY_FORECAST, &forecast, sizeof(forecast));
+			update_weather = true;
+		}
+		break;
+	case DEBUG_LATENCY:
+		// 0 is the initial value, anything else is a request.
+		if (new_values && new_values->value && new_values->value->uint8 != 0) {
+			send_latency_summary(new_values->value->uint8 == 2);
+		}
+		break;
 	case SIGNAL_STRENGTH_CELL:
 		if (new_values && new_values->value) {
 			signal_level_cell = new_values->value->uint8;
@@ -474,25 +631,82 @@ static void sync_tuple_changed_callback(const uint32_t key,
 			update_signals = true;
 		}
 		break;
+
+	case CONFIG_FEATURES:
+		if (new_values && new_values->value &&
+		    (new_values->value->uint32 & FEATURES_ALL) != features) {
+			uint32_t old_active = active_features();
+			features = new_values->value->uint32 & FEATURES_ALL;
+			APP_LOG(APP_LOG_LEVEL_DEBUG, "%s CONFIG_FEATURES: 0x%02x",
+				__FUNCTION__, (int) features);
+			persist_write_int(PERSIST_KEY_FEATURES, features);
+			features_apply(old_active);
+		}
+		break;
+	case CONFIG_LOW_BATTERY:
+		if (new_values && new_values->value &&
+		    new_values->value->uint8 != low_battery_percent) {
+			low_battery_percent = new_values->value->uint8;
+			APP_LOG(APP_LOG_LEVEL_DEBUG, "%s CONFIG_LOW_BATTERY: %d",
+				__FUNCTION__, low_battery_percent);
+			persist_write_int(PERSIST_KEY_LOW_BATTERY, low_battery_percent);
+			low_battery_check(battery_state_service_peek());
+		}
+		break;
 	};
 
-	if (update_battery) {
+	if (update_battery && (features_loaded & FEATURE_PHONE_BATTERY)) {
 		layer_mark_dirty(status_phone_battery_layer);
 	}
 
-	if (update_weather) {
-		draw_weather(weather_info);
+	if (update_weather && (features_loaded & FEATURE_WEATHER)) {
+		draw_weather(weather_now());
 	}
 
-	if (update_signals) {
+	if (update_signals && (features_loaded & FEATURE_SIGNAL)) {
 		draw_signals(signal_level_cell, cell_service_state);
 	}
+
+	latency_end(LATENCY_SYNC_CHANGED, start);
+}
+
+static void phone_sync_stop(void) {
+	if (sync_running) {
+		app_sync_deinit(&sync);
+		sync_running = false;
+	}
+}
+
+// Starts from the last known values so nothing flashes back to zero.
+// The phone only sends the keys for enabled features, see send_message().
+// Keep SYNC_INTEGER_KEYS in step with the list.
+static void phone_sync_start(void) {
+	phone_sync_stop();
+
+	Tuplet initial_message_values[] = {
+		TupletInteger(PHONE_BATTERY_PERCENT, (uint8_t) phone_battery_state.charge_percent),
+		TupletInteger(PHONE_BATTERY_CHARGING, (uint8_t) phone_battery_state.is_charging),
+		TupletInteger(PHONE_BATTERY_PLUGGED, (uint8_t) phone_battery_state.is_plugged),
+		TupletInteger(WEATHER_MESSAGE_ICON, (uint8_t) weather_info.icon),
+		TupletInteger(WEATHER_MESSAGE_TEMPERATURE, (int32_t) weather_info.temp),
+		TupletInteger(SIGNAL_STRENGTH_CELL, (uint8_t) signal_level_cell),
+		TupletInteger(CELL_SERVICE_STATE, (uint8_t) cell_service_state),
+		TupletInteger(CONFIG_FEATURES, features),
+		TupletInteger(CONFIG_LOW_BATTERY, low_battery_percent),
+		TupletBytes(WEATHER_FORECAST, forecast_packed, forecast_packed_size),
+		TupletInteger(DEBUG_LATENCY, (uint8_t) 0),
+	};
+	app_sync_init(&sync, sync_buffer, sizeof(sync_buffer),
+		      initial_message_values, ARRAY_LENGTH(initial_message_values),
+		      sync_tuple_changed_callback, sync_error_callback, NULL);
+	sync_running = true;
 }
 
 
 // ---------- Timer and watch update functions ------------------------------
 
 void handle_minute_tick(struct tm* tick_time, TimeUnits units_changed) {
+	uint32_t start = latency_start();
 
 	// If the month or year changes, the day will change, too.
 	if (units_changed & DAY_UNIT) {
@@ -500,18 +714,45 @@ void handle_minute_tick(struct tm* tick_time, TimeUnits units_changed) {
 		draw_date(tick_time);
 	}
 	draw_time(tick_time);
+
+	if (tick_time->tm_min == 0) {
+		if (active_features() & FEATURE_VIBRATE_HOURLY) {
+			vibes_enqueue_custom_pattern(HOUR_VIBE_PATTERN);
+		}
+
+		// Next hour of the forecast, and a new forecast before
+		// this one runs out.
+		if (features_loaded & FEATURE_WEATHER) {
+			draw_weather(weather_now());
+		}
+		if (forecast.count > 0 &&
+		    forecast_slots_left(&forecast, time(NULL)) <= FORECAST_REFRESH_SLOTS) {
+			request_phone_update(0);
+		}
+	}
+
+	latency_end(LATENCY_MINUTE_TICK, start);
 }
 
 void handle_battery_update(BatteryChargeState charge_state) {
-	layer_mark_dirty(status_phone_battery_layer);
+	uint32_t start = latency_start();
+	layer_mark_dirty(status_watch_battery_layer);
+	low_battery_check(charge_state);
+	latency_end(LATENCY_BATTERY, start);
 }
 
+AppTimer* bluetooth_timer;
+
 void bluetooth_timer_callback(void* ignored) {
+	uint32_t start = latency_start();
+	bluetooth_timer = NULL;
 	draw_bluetooth_warning(bluetooth_connection_service_peek());
+	latency_end(LATENCY_BLUETOOTH_TIMER, start);
 }
 
 void handle_bluetooth_update(bool connected)
 {
+	uint32_t start = latency_start();
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s %s", __FUNCTION__, (connected? "true": "false"));
 
 	if (connected) {
@@ -519,20 +760,300 @@ void handle_bluetooth_update(bool connected)
 	}
 	else {
 		// Don't show/buzz right away, wait for a few seconds.
-		// I'm not being smart here and cancelling any in-flight
-		// timers in the case we're flapping the connect/disconnect.
-		app_timer_register(BLUETOOTH_TIMEOUT_MS,
-				   bluetooth_timer_callback,
-				   NULL);
+		// If the connection is flapping, start the wait over
+		// rather than stacking up another timer.
+		if (bluetooth_timer) {
+			app_timer_cancel(bluetooth_timer);
+		}
+		bluetooth_timer = app_timer_register(BLUETOOTH_TIMEOUT_MS,
+						     bluetooth_timer_callback,
+						     NULL);
+	}
+
+	latency_end(LATENCY_BLUETOOTH, start);
+}
+
+
+// ---------- Feature modules ------------------------------
+// Each optional feature creates its layers when it's turned on and
+// destroys them when it's turned off, so a feature that's off costs
+// no heap and no redraws.
+
+#define SMALL_TIME_HEIGHT 16
+#define BIG_TIME_HEIGHT 58 // TIME_HEIGHT - SMALL_TIME_HEIGHT
+#define SMALL_TIME_WIDTH 48 // TIME_WIDTH / 3
+
+static void timezones_load(void) {
+	time_text_reset(&tz1_text);
+	time_text_reset(&tz2_text);
+
+	time_tz1_text_layer = text_layer_create((GRect) { .origin = { 0, BIG_TIME_HEIGHT },
+				.size = { SMALL_TIME_WIDTH, SMALL_TIME_HEIGHT } });
+
+	text_layer_set_text_color(time_tz1_text_layer, GColorWhite);
+	text_layer_set_text_alignment(time_tz1_text_layer, GTextAlignmentCenter);
+	text_layer_set_background_color(time_tz1_text_layer, GColorClear);
+	text_layer_set_font(time_tz1_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+
+	time_tz2_text_layer = text_layer_create((GRect) { .origin = { SMALL_TIME_WIDTH*2, BIG_TIME_HEIGHT },
+				.size = { SMALL_TIME_WIDTH, SMALL_TIME_HEIGHT } });
+
+	text_layer_set_text_color(time_tz2_text_layer, GColorWhite);
+	text_layer_set_text_alignment(time_tz2_text_layer, GTextAlignmentCenter);
+	text_layer_set_background_color(time_tz2_text_layer, GColorClear);
+	text_layer_set_font(time_tz2_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+
+	layer_add_child(time_layer, text_layer_get_layer(time_tz1_text_layer));
+	layer_add_child(time_layer, text_layer_get_layer(time_tz2_text_layer));
+}
+
+static void timezones_unload(void) {
+	layer_remove_from_parent(text_layer_get_layer(time_tz2_text_layer));
+	layer_remove_from_parent(text_layer_get_layer(time_tz1_text_layer));
+	text_layer_destroy(time_tz2_text_layer);
+	text_layer_destroy(time_tz1_text_layer);
+	time_tz2_text_layer = NULL;
+	time_tz1_text_layer = NULL;
+}
+
+static void beats_load(void) {
+	beats_text_reset(&beats_text);
+
+	time_beats_text_layer = text_layer_create((GRect) { .origin = { SMALL_TIME_WIDTH, BIG_TIME_HEIGHT },
+				.size = { SMALL_TIME_WIDTH, SMALL_TIME_HEIGHT } });
+
+	text_layer_set_text_color(time_beats_text_layer, GColorWhite);
+	text_layer_set_text_alignment(time_beats_text_layer, GTextAlignmentCenter);
+	text_layer_set_background_color(time_beats_text_layer, GColorClear);
+	text_layer_set_font(time_beats_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+
+	layer_add_child(time_layer, text_layer_get_layer(time_beats_text_layer));
+}
+
+static void beats_unload(void) {
+	layer_remove_from_parent(text_layer_get_layer(time_beats_text_layer));
+	text_layer_destroy(time_beats_text_layer);
+	time_beats_text_layer = NULL;
+}
+
+static void weather_load(void) {
+	GRect weather_rect = { .origin = { WEATHER_X, WEATHER_Y },
+			       .size = { WEATHER_WIDTH, WEATHER_HEIGHT } };
+
+	weather_layer = layer_create(weather_rect);
+
+	// Two layers, each half the width
+	// conditions        temperature
+	int half_w = WEATHER_WIDTH / 2.0;
+
+	// XXX create weather icon bitmaps statically
+	weather_cond_layer = bitmap_layer_create((GRect) { .origin = { 0, 0 },
+				.size = { half_w, WEATHER_HEIGHT } });
+	weather_temp_layer = text_layer_create((GRect) { .origin = { half_w, 5 },
+				.size = { half_w, WEATHER_HEIGHT } });
+
+	weather_cond_bitmap = gbitmap_create_with_resource(WEATHER_ICONS[WEATHER_ICON_NONE]);
+	bitmap_layer_set_bitmap(weather_cond_layer, weather_cond_bitmap);
+	weather_shown_icon = WEATHER_ICON_NONE;
+	weather_shown_temp = INT32_MIN; // Nothing shown yet
+
+	text_layer_set_text_color(weather_temp_layer, GColorWhite);
+	text_layer_set_text_alignment(weather_temp_layer, GTextAlignmentCenter);
+	text_layer_set_background_color(weather_temp_layer, GColorClear);
+	text_layer_set_font(weather_temp_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+
+	layer_add_child(weather_layer, bitmap_layer_get_layer(weather_cond_layer));
+	layer_add_child(weather_layer, text_layer_get_layer(weather_temp_layer));
+
+	layer_add_child(window_get_root_layer(window), weather_layer);
+}
+
+static void weather_unload(void) {
+	layer_remove_from_parent(weather_layer);
+
+	gbitmap_destroy(weather_cond_bitmap);
+	bitmap_layer_destroy(weather_cond_layer);
+	text_layer_destroy(weather_temp_layer);
+	layer_destroy(weather_layer);
+
+	weather_cond_bitmap = NULL;
+	weather_cond_layer = NULL;
+	weather_temp_layer = NULL;
+	weather_layer = NULL;
+}
+
+static void phone_battery_load(void) {
+	int layer_w = STATUS_WIDTH / 3.0;
+	status_phone_battery_layer = layer_create((GRect) { .origin = { STATUS_WIDTH - layer_w, 0 },
+				.size = { layer_w, STATUS_HEIGHT } });
+	layer_set_update_proc(status_phone_battery_layer, draw_battery_phone_callback);
+	layer_add_child(status_layer, status_phone_battery_layer);
+}
+
+static void phone_battery_unload(void) {
+	layer_remove_from_parent(status_phone_battery_layer);
+	layer_destroy(status_phone_battery_layer);
+	status_phone_battery_layer = NULL;
+}
+
+static void signal_load(void) {
+	GRect signal_rect = { .origin = { SIGNAL_X, SIGNAL_Y },
+			       .size = { SIGNAL_WIDTH, SIGNAL_HEIGHT } };
+
+	signal_layer = layer_create(signal_rect);
+
+	signal_strength_layer = text_layer_create(signal_rect);
+
+	text_layer_set_text_color(signal_strength_layer, GColorWhite);
+	text_layer_set_text_alignment(signal_strength_layer, GTextAlignmentCenter);
+	text_layer_set_background_color(signal_strength_layer, GColorClear);
+	text_layer_set_font(signal_strength_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+
+	layer_add_child(signal_layer, text_layer_get_layer(signal_strength_layer));
+
+	layer_add_child(window_get_root_layer(window), signal_layer);
+}
+
+static void signal_unload(void) {
+	layer_remove_from_parent(signal_layer);
+	text_layer_destroy(signal_strength_layer);
+	layer_destroy(signal_layer);
+	signal_strength_layer = NULL;
+	signal_layer = NULL;
+}
+
+typedef struct {
+	Feature feature;
+	void (*load)(void);
+	void (*unload)(void);
+} FeatureModule;
+
+// The hourly vibe has no layers, the tick handler just checks the setting.
+static const FeatureModule FEATURE_MODULES[] = {
+	{ FEATURE_TIMEZONES, timezones_load, timezones_unload },
+	{ FEATURE_BEATS, beats_load, beats_unload },
+	{ FEATURE_WEATHER, weather_load, weather_unload },
+	{ FEATURE_PHONE_BATTERY, phone_battery_load, phone_battery_unload },
+	{ FEATURE_SIGNAL, signal_load, signal_unload },
+};
+
+// Load and unload modules until the loaded ones match what's wanted.
+static void features_load(uint32_t wanted) {
+	for (unsigned i = 0; i < ARRAY_LENGTH(FEATURE_MODULES); i++) {
+		const FeatureModule* module = &FEATURE_MODULES[i];
+		bool want = (wanted & module->feature);
+		bool loaded = (features_loaded & module->feature);
+
+		if (want && !loaded) {
+			module->load();
+			features_loaded |= module->feature;
+		}
+		else if (!want && loaded) {
+			module->unload();
+			features_loaded &= ~module->feature;
+		}
 	}
 }
 
+// Draw everything that's loaded from the current time and last known state.
+static void draw_all(void) {
+	time_t now = time(NULL);
+	struct tm* ptime = localtime(&now);
+
+	// Draw all the (local) things!
+	draw_dayofweek(ptime);
+	draw_date(ptime);
+	draw_time(ptime);
+
+	// Draw the last known state of the phone information.
+	if (features_loaded & FEATURE_WEATHER) {
+		draw_weather(weather_now());
+	}
+	if (features_loaded & FEATURE_SIGNAL) {
+		draw_signals(signal_level_cell, cell_service_state);
+	}
+}
+
+// New settings from the phone, or the battery mode changed.
+static void features_apply(uint32_t old_active) {
+	uint32_t active = active_features();
+
+	features_load(active);
+	draw_all();
+
+	if (!(active & FEATURES_PHONE)) {
+		if (send_message_timer) {
+			app_timer_cancel(send_message_timer);
+			send_message_timer = NULL;
+		}
+		if (old_active & FEATURES_PHONE) {
+			// Nothing wants the phone any more, so let it know
+			// it can stop sending.
+			send_message_timer = app_timer_register(0, send_message_callback, NULL);
+		}
+	}
+	else if (active & FEATURES_PHONE & ~old_active) {
+		// Something new wants phone data, so ask for it.
+		request_phone_update(0);
+	}
+}
+
+
+// ---------- Low battery mode ------------------------------
+
+static bool low_battery_wanted(BatteryChargeState charge) {
+	if (charge.is_charging || charge.is_plugged || low_battery_percent == 0) {
+		return false;
+	}
+	if (low_battery_mode) {
+		return charge.charge_percent < low_battery_percent + LOW_BATTERY_HYSTERESIS;
+	}
+	return charge.charge_percent <= low_battery_percent;
+}
+
+// Add the time since the last call to the current mode.
+static void mode_times_update(void) {
+	time_t now = time(NULL);
+	uint32_t elapsed = (now > mode_since ? now - mode_since : 0);
+	if (low_battery_mode) {
+		mode_times.low += elapsed;
+	}
+	else {
+		mode_times.normal += elapsed;
+	}
+	mode_since = now;
+}
+
+static void low_battery_check(BatteryChargeState charge) {
+	bool wanted = low_battery_wanted(charge);
+	if (wanted == low_battery_mode) {
+		return;
+	}
+
+	uint32_t old_active = active_features();
+
+	mode_times_update();
+	persist_write_data(PERSIST_KEY_MODE_TIMES, &mode_times, sizeof(mode_times));
+	APP_LOG(APP_LOG_LEVEL_INFO, "Low battery mode %s at %d%%, %lu s normal, %lu s low so far",
+		(wanted ? "on" : "off"), charge.charge_percent,
+		(unsigned long) mode_times.normal, (unsigned long) mode_times.low);
+
+	low_battery_mode = wanted;
+	layer_set_hidden(status_layer, low_battery_mode);
+	features_apply(old_active);
+}
+
 
 // ---------- Window and layer functions ------------------------------
 
 static void window_load(Window* win) {
+	uint32_t start = latency_start();
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s", __FUNCTION__);
 
+	// New layers have no text yet, so the next draw writes everything.
+	date_text_reset(&date_text);
+	time_text_reset(&time_text);
+
 	// Status layers
 	{
 		// 3 beside each other:
@@ -546,11 +1067,8 @@ static void window_load(Window* win) {
 					.size = { layer_w, STATUS_HEIGHT } });
 		status_bluetooth_warn_layer = text_layer_create((GRect) { .origin = { layer_w, 0 },
 					.size = { layer_w, STATUS_HEIGHT } });
-		status_phone_battery_layer = layer_create((GRect) { .origin = { STATUS_WIDTH - layer_w, 0 },
-					.size = { layer_w, STATUS_HEIGHT } });
 
 		layer_set_update_proc(status_watch_battery_layer, draw_battery_watch_callback);
-		layer_set_update_proc(status_phone_battery_layer, draw_battery_phone_callback);
 
 		text_layer_set_text_color(status_bluetooth_warn_layer, GColorWhite);
 		text_layer_set_text_alignment(status_bluetooth_warn_layer, GTextAlignmentCenter);
@@ -558,10 +1076,10 @@ static void window_load(Window* win) {
 		text_layer_set_font(status_bluetooth_warn_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
 
 		layer_add_child(status_layer, status_watch_battery_layer);
-		layer_add_child(status_layer, status_phone_battery_layer);
 		layer_add_child(status_layer, text_layer_get_layer(status_bluetooth_warn_layer));
 
 		layer_add_child(window_get_root_layer(win), status_layer);
+		layer_set_hidden(status_layer, low_battery_mode);
 	}
 
 	// Date layers
@@ -596,7 +1114,7 @@ static void window_load(Window* win) {
 		layer_add_child(window_get_root_layer(win), date_layer);
 	}
 
-	// Time layers
+	// Time layer, the small times under it are feature modules
 	{
 		// Big time
 		GRect time_rect = { .origin = { TIME_X, TIME_Y },
@@ -604,155 +1122,47 @@ static void window_load(Window* win) {
 
 		time_layer = layer_create(time_rect);
 
-		int small_time_h = 16;
-		int big_time_h = TIME_HEIGHT - small_time_h;
-
 		time_text_layer = text_layer_create((GRect) { .origin = { 0, 0 },
-					.size = { TIME_WIDTH, big_time_h } });
+					.size = { TIME_WIDTH, BIG_TIME_HEIGHT } });
 
 		text_layer_set_text_color(time_text_layer, GColorWhite);
 		text_layer_set_text_alignment(time_text_layer, GTextAlignmentCenter);
 		text_layer_set_background_color(time_text_layer, GColorClear);
 		text_layer_set_font(time_text_layer, font_49_numbers);
 
-		int small_time_w = TIME_WIDTH / 3.0;
-
-		time_tz1_text_layer = text_layer_create((GRect) { .origin = { 0, big_time_h },
-					.size = { small_time_w, small_time_h } });
-
-		text_layer_set_text_color(time_tz1_text_layer, GColorWhite);
-		text_layer_set_text_alignment(time_tz1_text_layer, GTextAlignmentCenter);
-		text_layer_set_background_color(time_tz1_text_layer, GColorClear);
-		text_layer_set_font(time_tz1_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
-
-		time_beats_text_layer = text_layer_create((GRect) { .origin = { small_time_w, big_time_h },
-					.size = { small_time_w, small_time_h } });
-
-		text_layer_set_text_color(time_beats_text_layer, GColorWhite);
-		text_layer_set_text_alignment(time_beats_text_layer, GTextAlignmentCenter);
-		text_layer_set_background_color(time_beats_text_layer, GColorClear);
-		text_layer_set_font(time_beats_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
-
-		time_tz2_text_layer = text_layer_create((GRect) { .origin = { small_time_w*2, big_time_h },
-					.size = { small_time_w, small_time_h } });
-
-		text_layer_set_text_color(time_tz2_text_layer, GColorWhite);
-		text_layer_set_text_alignment(time_tz2_text_layer, GTextAlignmentCenter);
-		text_layer_set_background_color(time_tz2_text_layer, GColorClear);
-		text_layer_set_font(time_tz2_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
-
 		layer_add_child(time_layer, text_layer_get_layer(time_text_layer));
-		layer_add_child(time_layer, text_layer_get_layer(time_tz1_text_layer));
-		layer_add_child(time_layer, text_layer_get_layer(time_beats_text_layer));
-		layer_add_child(time_layer, text_layer_get_layer(time_tz2_text_layer));
 
 		layer_add_child(window_get_root_layer(win), time_layer);
 	}
 
-	// Weather layer
-	{
-		GRect weather_rect = { .origin = { WEATHER_X, WEATHER_Y },
-				       .size = { WEATHER_WIDTH, WEATHER_HEIGHT } };
-
-		weather_layer = layer_create(weather_rect);
-
-		// Two layers, each half the width
-		// conditions        temperature
-		int half_w = WEATHER_WIDTH / 2.0;
-
-		// XXX create weather icon bitmaps statically
-		weather_cond_layer = bitmap_layer_create((GRect) { .origin = { 0, 0 },
-					.size = { half_w, WEATHER_HEIGHT } });
-		weather_temp_layer = text_layer_create((GRect) { .origin = { half_w, 5 },
-					.size = { half_w, WEATHER_HEIGHT } });
-
-		weather_cond_bitmap = gbitmap_create_with_resource(WEATHER_ICONS[WEATHER_ICON_NONE]);
-		bitmap_layer_set_bitmap(weather_cond_layer, weather_cond_bitmap);
-
-		text_layer_set_text_color(weather_temp_layer, GColorWhite);
-		text_layer_set_text_alignment(weather_temp_layer, GTextAlignmentCenter);
-		text_layer_set_background_color(weather_temp_layer, GColorClear);
-		text_layer_set_font(weather_temp_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
-
-		layer_add_child(weather_layer, bitmap_layer_get_layer(weather_cond_layer));
-		layer_add_child(weather_layer, text_layer_get_layer(weather_temp_layer));
-
-		layer_add_child(window_get_root_layer(win), weather_layer);
-	}
-
-	// Signal strength layer
-	{
-		GRect signal_rect = { .origin = { SIGNAL_X, SIGNAL_Y },
-				       .size = { SIGNAL_WIDTH, SIGNAL_HEIGHT } };
-
-		signal_layer = layer_create(signal_rect);
-
-		signal_strength_layer = text_layer_create(signal_rect);
-
-		text_layer_set_text_color(signal_strength_layer, GColorWhite);
-		text_layer_set_text_alignment(signal_strength_layer, GTextAlignmentCenter);
-		text_layer_set_background_color(signal_strength_layer, GColorClear);
-		text_layer_set_font(signal_strength_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
-
-		layer_add_child(signal_layer, text_layer_get_layer(signal_strength_layer));
+	// Whatever's turned on in the settings
+	features_load(active_features());
 
-		layer_add_child(window_get_root_layer(win), signal_layer);
-	}
+	latency_end(LATENCY_WINDOW_LOAD, start);
 }
 
 static void window_appear(Window* win) {
 	// Update here to avoid blank display on launch
 	// and to update when the window is redrawn.
+	uint32_t start = latency_start();
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s", __FUNCTION__);
 
-	time_t now = time(NULL);
-	struct tm* ptime = localtime(&now);
-
-	// Draw all the (local) things!
-	draw_dayofweek(ptime);
-	draw_date(ptime);
-	draw_time(ptime);
+	draw_all();
 	draw_bluetooth_warning(bluetooth_connection_service_peek());
 
-	// Draw the last known state of the phone information.
-	draw_weather(weather_info);
-	draw_signals(signal_level_cell, cell_service_state);
-
-	Tuplet initial_message_values[] = {
-		TupletInteger(PHONE_BATTERY_PERCENT, (uint8_t) 0),
-		TupletInteger(PHONE_BATTERY_CHARGING, (uint8_t) 0),
-		TupletInteger(PHONE_BATTERY_PLUGGED, (uint8_t) 0),
-		TupletInteger(WEATHER_MESSAGE_ICON, (uint8_t) 0),
-		TupletInteger(WEATHER_MESSAGE_TEMPERATURE, (int32_t) 0),
-		TupletInteger(SIGNAL_STRENGTH_CELL, (uint8_t) 0),
-	};
-	app_sync_init(&sync, sync_buffer, sizeof(sync_buffer),
-		      initial_message_values, ARRAY_LENGTH(initial_message_values),
-		      sync_tuple_changed_callback, sync_error_callback, NULL);
-
 	// Let initialization happen, then send the message to get the
 	// values from the phone.
-	app_timer_register(1000 /* ms */,
-			   send_message_callback,
-			   NULL);
+	request_phone_update(1000 /* ms */);
+
+	latency_end(LATENCY_WINDOW_APPEAR, start);
 }
 
 static void window_unload(Window *win) {
+	uint32_t start = latency_start();
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s", __FUNCTION__);
 
-	app_sync_deinit(&sync);
-
-	text_layer_destroy(signal_strength_layer);
-	layer_destroy(signal_layer);
-
-	gbitmap_destroy(weather_cond_bitmap);
-	bitmap_layer_destroy(weather_cond_layer);
-	text_layer_destroy(weather_temp_layer);
-	layer_destroy(weather_layer);
+	features_load(0);
 
-	text_layer_destroy(time_tz2_text_layer);
-	text_layer_destroy(time_beats_text_layer);
-	text_layer_destroy(time_tz1_text_layer);
 	text_layer_destroy(time_text_layer);
 	layer_destroy(time_layer);
 
@@ -761,14 +1171,43 @@ static void window_unload(Window *win) {
 	layer_destroy(date_layer);
 
 	text_layer_destroy(status_bluetooth_warn_layer);
-	layer_destroy(status_phone_battery_layer);
 	layer_destroy(status_watch_battery_layer);
 	layer_destroy(status_layer);
+
+	latency_end(LATENCY_WINDOW_UNLOAD, start);
 }
 
 void do_init() {
 	APP_LOG(APP_LOG_LEVEL_DEBUG, "%s", __FUNCTION__);
 
+	time_format_set_locale(i18n_get_system_locale());
+
+	features = FEATURES_DEFAULT;
+	if (persist_exists(PERSIST_KEY_FEATURES)) {
+		features = persist_read_int(PERSIST_KEY_FEATURES) & FEATURES_ALL;
+	}
+	low_battery_percent = LOW_BATTERY_PERCENT_DEFAULT;
+	if (persist_exists(PERSIST_KEY_LOW_BATTERY)) {
+		low_battery_percent = persist_read_int(PERSIST_KEY_LOW_BATTERY);
+	}
+
+	// Pick the mode before the window loads its layers.
+	memset(&mode_times, 0, sizeof(mode_times));
+	persist_read_data(PERSIST_KEY_MODE_TIMES, &mode_times, sizeof(mode_times));
+	mode_since = time(NULL);
+	low_battery_mode = false;
+	low_battery_mode = low_battery_wanted(battery_state_service_peek());
+
+	// Init the information from the phone until we have real info.
+	memset(&phone_battery_state, 0, sizeof(phone_battery_state));
+	memset(&weather_info, 0, sizeof(weather_info));
+	forecast_reset(&forecast);
+	forecast_packed_size = 0;
+	if (persist_read_data(PERSIST_KEY_FORECAST, &forecast, sizeof(forecast)) != sizeof(forecast) ||
+	    forecast.count > FORECAST_MAX_SLOTS) {
+		forecast_reset(&forecast);
+	}
+
 	// Load the fonts before anything in the window functions
 	// tries to use them.
 	font_21 = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_UBUNTU_21));
@@ -790,11 +1229,8 @@ void do_init() {
 	battery_state_service_subscribe(&handle_battery_update);
 	bluetooth_connection_service_subscribe(&handle_bluetooth_update);
 
-	// Init the information from the phone until we have real info.
-	memset(&phone_battery_state, 0, sizeof(phone_battery_state));
-	memset(&weather_info, 0, sizeof(weather_info));
-
 	app_message_open(INBOUND_MESSAGE_SIZE, OUTBOUND_MESSAGE_SIZE);
+	phone_sync_start();
 }
 
 void do_deinit(void) {
@@ -804,6 +1240,19 @@ void do_deinit(void) {
 	battery_state_service_unsubscribe();
 	bluetooth_connection_service_unsubscribe();
 
+	mode_times_update();
+	persist_write_data(PERSIST_KEY_MODE_TIMES, &mode_times, sizeof(mode_times));
+
+	phone_sync_stop();
+	if (send_message_timer) {
+		app_timer_cancel(send_message_timer);
+		send_message_timer = NULL;
+	}
+	if (bluetooth_timer) {
+		app_timer_cancel(bluetooth_timer);
+		bluetooth_timer = NULL;
+	}
+
 	window_destroy(window);
 
 	fonts_unload_custom_font(font_49_numbers);
@@ -0,0 +1,59 @@
+#include "forecast.h"
+
+void forecast_reset(Forecast* f) {
+	f->start = 0;
+	f->count = 0;
+}
+
+bool forecast_decode(Forecast* f, const uint8_t* data, uint16_t size, time_t now) {
+	forecast_reset(f);
+
+	if (size <= FORECAST_HEADER_SIZE || size > FORECAST_PACKED_MAX || data[0] > 23) {
+		return false;
+	}
+
+	// The first slot starts at the top of the hour nearest to the given
+	// hour of day.  Usually the current hour, the next one if the
+	// phone's clock is a little ahead as the hour turns over.
+	struct tm* local = localtime(&now);
+	int hours = data[0] - local->tm_hour;
+	if (hours > 12) {
+		hours -= 24;
+	}
+	else if (hours < -12) {
+		hours += 24;
+	}
+	time_t start = now - local->tm_min * 60 - local->tm_sec + hours * FORECAST_SLOT_SECONDS;
+
+	int8_t base = (int8_t) data[1];
+	for (uint16_t i = FORECAST_HEADER_SIZE; i < size; i++) {
+		ForecastSlot* slot = &f->slots[f->count++];
+		int8_t delta = data[i] & FORECAST_DELTA_MASK;
+		if (delta > FORECAST_DELTA_MASK / 2) {
+			delta -= FORECAST_DELTA_MASK + 1;
+		}
+		slot->icon = data[i] >> FORECAST_ICON_SHIFT;
+		slot->temp = base + delta;
+	}
+
+	f->start = start;
+	return true;
+}
+
+static int forecast_index(const Forecast* f, time_t now) {
+	if (f->count == 0 || now < f->start) {
+		return -1;
+	}
+	int index = (now - f->start) / FORECAST_SLOT_SECONDS;
+	return (index < f->count ? index : -1);
+}
+
+const ForecastSlot* forecast_slot(const Forecast* f, time_t now) {
+	int index = forecast_index(f, now);
+	return (index < 0 ? NULL : &f->slots[index]);
+}
+
+int forecast_slots_left(const Forecast* f, time_t now) {
+	int index = forecast_index(f, now);
+	return (index < 0 ? 0 : f->count - index);
+}
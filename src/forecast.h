@@ -0,0 +1,49 @@
+/*
+Hourly weather forecast, packed by the phone into one byte array:
+
+  byte 0   local hour of day of the first slot (0-23)
+  byte 1   base temperature, signed degrees C
+  byte 2+  one byte per hour: icon code in the top 3 bits, signed
+           difference from the base temperature in the low 5 bits
+
+The watch decodes it once into a fixed array and steps through the
+slots as the hours pass, so one message covers up to a day.
+*/
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <pebble.h>
+
+#define FORECAST_MAX_SLOTS 24
+#define FORECAST_HEADER_SIZE 2
+#define FORECAST_PACKED_MAX (FORECAST_HEADER_SIZE + FORECAST_MAX_SLOTS)
+
+#define FORECAST_SLOT_SECONDS (60 * 60)
+#define FORECAST_ICON_SHIFT 5
+#define FORECAST_DELTA_MASK 0x1F // -16 to +15 degrees
+
+typedef struct {
+	uint8_t icon; // WeatherIconCode
+	int8_t temp;
+} ForecastSlot;
+
+typedef struct {
+	time_t start; // time() when the first slot starts
+	uint8_t count;
+	ForecastSlot slots[FORECAST_MAX_SLOTS];
+} Forecast;
+
+void forecast_reset(Forecast* f);
+
+// Decode a packed forecast received at time() now.  A forecast that
+// doesn't fit the format above leaves f empty and returns false.
+bool forecast_decode(Forecast* f, const uint8_t* data, uint16_t size, time_t now);
+
+// The slot covering time() now, NULL before or after the forecast.
+const ForecastSlot* forecast_slot(const Forecast* f, time_t now);
+
+// Slots left from the one covering now, including it.
+int forecast_slots_left(const Forecast* f, time_t now);
+
+#endif // FORECAST_H
@@ -0,0 +1,101 @@
+#include "latency.h"
+
+LatencyHistogram latency_histograms[LATENCY_PROBE_COUNT];
+
+static const char* PROBE_NAMES[LATENCY_PROBE_COUNT] = {
+	"minute tick",
+	"battery",
+	"bluetooth",
+	"send message timer",
+	"bluetooth timer",
+	"sync changed",
+	"window load",
+	"window appear",
+	"window unload",
+	"draw watch battery",
+	"draw phone battery",
+};
+
+uint32_t latency_start(void) {
+	time_t seconds;
+	uint16_t ms;
+	time_ms(&seconds, &ms);
+	return (uint32_t) seconds * 1000 + ms;
+}
+
+void latency_end(LatencyProbe probe, uint32_t start) {
+	uint32_t elapsed = latency_start() - start;
+	LatencyHistogram* h = &latency_histograms[probe];
+
+	// 0 -> bucket 0, 1 -> 1, 2-3 -> 2, 4-7 -> 3 ...
+	int bucket = 0;
+	for (uint32_t e = elapsed; e > 0 && bucket < LATENCY_BUCKETS - 1; e >>= 1) {
+		bucket++;
+	}
+
+	// Halve them all when one fills up, so the percentiles keep the
+	// shape of the distribution on a watch that runs for weeks.
+	if (h->buckets[bucket] == UINT16_MAX) {
+		for (int i = 0; i < LATENCY_BUCKETS; i++) {
+			h->buckets[i] >>= 1;
+		}
+	}
+	h->calls++;
+	h->buckets[bucket]++;
+	if (elapsed > h->max_ms) {
+		h->max_ms = (elapsed < UINT16_MAX ? elapsed : UINT16_MAX);
+	}
+}
+
+void latency_reset(void) {
+	memset(latency_histograms, 0, sizeof(latency_histograms));
+}
+
+const char* latency_probe_name(LatencyProbe probe) {
+	return PROBE_NAMES[probe];
+}
+
+uint8_t latency_bucket_limit_ms(int bucket) {
+	return (bucket < LATENCY_BUCKETS - 1 ? 1 << bucket : 255);
+}
+
+uint8_t latency_percentile_ms(const LatencyHistogram* h, int percent) {
+	uint32_t total = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++) {
+		total += h->buckets[i];
+	}
+	if (total == 0) {
+		return 0;
+	}
+
+	uint32_t wanted = (total * percent + 99) / 100;
+	uint32_t seen = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= wanted) {
+			return latency_bucket_limit_ms(i);
+		}
+	}
+	return latency_bucket_limit_ms(LATENCY_BUCKETS - 1);
+}
+
+uint16_t latency_summary(uint8_t* data, uint16_t size) {
+	if (size < LATENCY_SUMMARY_SIZE) {
+		return 0;
+	}
+
+	uint8_t* p = data;
+	*p++ = LATENCY_PROBE_COUNT;
+	for (int i = 0; i < LATENCY_PROBE_COUNT; i++) {
+		const LatencyHistogram* h = &latency_histograms[i];
+		*p++ = h->calls;
+		*p++ = h->calls >> 8;
+		*p++ = h->calls >> 16;
+		*p++ = h->calls >> 24;
+		*p++ = h->max_ms;
+		*p++ = h->max_ms >> 8;
+		*p++ = latency_percentile_ms(h, 50);
+		*p++ = latency_percentile_ms(h, 95);
+	}
+	return p - data;
+}
@@ -0,0 +1,64 @@
+/*
+How long the event handlers and layer update procs take, measured with
+time_ms() and kept in fixed histograms in static memory.
+
+Bucket 0 is under 1 ms, then each bucket doubles: 1, 2-3, 4-7 ... and
+the last one holds everything from 64 ms up.  When a bucket fills up
+they are all halved, so the buckets keep the shape of the distribution
+and calls the real count.
+
+The summary for the phone (DEBUG_LATENCY) is a byte array:
+
+  byte 0   number of probes
+  then per probe, in LatencyProbe order, 8 bytes:
+    calls    uint32, little endian
+    max ms   uint16, little endian
+    p50 ms   uint8, the median is under this, from the bucket limits
+    p95 ms   uint8, the same for the 95th percentile, 255 for 64 ms up
+*/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <pebble.h>
+
+typedef enum {
+	LATENCY_MINUTE_TICK,
+	LATENCY_BATTERY,
+	LATENCY_BLUETOOTH,
+	LATENCY_SEND_MESSAGE_TIMER,
+	LATENCY_BLUETOOTH_TIMER,
+	LATENCY_SYNC_CHANGED,
+	LATENCY_WINDOW_LOAD,
+	LATENCY_WINDOW_APPEAR,
+	LATENCY_WINDOW_UNLOAD,
+	LATENCY_DRAW_WATCH_BATTERY,
+	LATENCY_DRAW_PHONE_BATTERY,
+	LATENCY_PROBE_COUNT,
+} LatencyProbe;
+
+#define LATENCY_BUCKETS 8
+#define LATENCY_PROBE_SUMMARY_SIZE 8
+#define LATENCY_SUMMARY_SIZE (1 + LATENCY_PROBE_COUNT * LATENCY_PROBE_SUMMARY_SIZE)
+
+typedef struct {
+	uint32_t calls;
+	uint16_t max_ms;
+	uint16_t buckets[LATENCY_BUCKETS]; // All halved when one would pass 65535
+} LatencyHistogram;
+
+extern LatencyHistogram latency_histograms[LATENCY_PROBE_COUNT];
+
+// Milliseconds on a clock that wraps, only good for differences.
+uint32_t latency_start(void);
+void latency_end(LatencyProbe probe, uint32_t start);
+
+void latency_reset(void);
+const char* latency_probe_name(LatencyProbe probe);
+uint8_t latency_bucket_limit_ms(int bucket); // Everything in it is under this, 255 for the last
+uint8_t latency_percentile_ms(const LatencyHistogram* h, int percent);
+
+// Writes the summary described above, returns its size or 0 if it doesn't fit.
+uint16_t latency_summary(uint8_t* data, uint16_t size);
+
+#endif // LATENCY_H
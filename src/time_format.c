@@ -0,0 +1,144 @@
+#include "time_format.h"
+
+#define DECADE(d) #d "0" #d "1" #d "2" #d "3" #d "4" #d "5" #d "6" #d "7" #d "8" #d "9"
+
+// "00" through "99", two characters each.
+static const char DIGIT_PAIRS[] =
+	DECADE(0) DECADE(1) DECADE(2) DECADE(3) DECADE(4)
+	DECADE(5) DECADE(6) DECADE(7) DECADE(8) DECADE(9);
+
+typedef struct {
+	const char* language; // First two letters of the locale, "en_US" -> "en"
+	const char* weekdays[7];
+} LocaleNames;
+
+static const LocaleNames LOCALES[] = {
+	{ "en", { "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday" } },
+	{ "de", { "Sonntag", "Montag", "Dienstag", "Mittwoch", "Donnerstag", "Freitag", "Samstag" } },
+	{ "fr", { "dimanche", "lundi", "mardi", "mercredi", "jeudi", "vendredi", "samedi" } },
+	{ "es", { "domingo", "lunes", "martes", "miércoles", "jueves", "viernes", "sábado" } },
+};
+
+static const LocaleNames* locale_names = &LOCALES[0];
+
+static inline void put_two_digits(char* s, int n) {
+	memcpy(s, &DIGIT_PAIRS[n * 2], 2);
+}
+
+// ---------- Time ------------------------------
+
+void time_text_reset(TimeText* tt) {
+	tt->text[0] = '\0';
+	tt->hour = -1;
+	tt->minute = -1;
+}
+
+bool time_text_update(TimeText* tt, const struct tm* t, bool is_24h) {
+	int hour = t->tm_hour;
+	if (!is_24h) {
+		hour %= 12;
+		if (hour == 0) {
+			hour = 12;
+		}
+	}
+
+	// No leading zero for 12-hour times, so the minutes move
+	// depending on the hour.
+	bool two_digit_hour = (is_24h || hour >= 10);
+
+	if (hour != tt->hour || is_24h != tt->is_24h) {
+		char* s = tt->text;
+		if (two_digit_hour) {
+			put_two_digits(s, hour);
+			s += 2;
+		}
+		else {
+			*s++ = '0' + hour;
+		}
+		*s++ = ':';
+		put_two_digits(s, t->tm_min);
+		s[2] = '\0';
+
+		tt->hour = hour;
+		tt->minute = t->tm_min;
+		tt->is_24h = is_24h;
+		return true;
+	}
+
+	if (t->tm_min != tt->minute) {
+		put_two_digits(&tt->text[two_digit_hour ? 3 : 2], t->tm_min);
+		tt->minute = t->tm_min;
+		return true;
+	}
+
+	return false;
+}
+
+// ---------- Date ------------------------------
+
+void date_text_reset(DateText* dt) {
+	memcpy(dt->text, "0000-00-00", sizeof(dt->text));
+	dt->year = -1;
+	dt->month = -1;
+	dt->mday = -1;
+}
+
+bool date_text_update(DateText* dt, const struct tm* t) {
+	bool changed = false;
+	int year = t->tm_year + 1900;
+
+	if (year != dt->year) {
+		put_two_digits(&dt->text[0], (year / 100) % 100);
+		put_two_digits(&dt->text[2], year % 100);
+		dt->year = year;
+		changed = true;
+	}
+	if (t->tm_mon != dt->month) {
+		put_two_digits(&dt->text[5], t->tm_mon + 1);
+		dt->month = t->tm_mon;
+		changed = true;
+	}
+	if (t->tm_mday != dt->mday) {
+		put_two_digits(&dt->text[8], t->tm_mday);
+		dt->mday = t->tm_mday;
+		changed = true;
+	}
+
+	return changed;
+}
+
+// ---------- .beats ------------------------------
+
+void beats_text_reset(BeatsText* bt) {
+	memcpy(bt->text, "@000", sizeof(bt->text));
+	bt->beats = -1;
+}
+
+bool beats_text_update(BeatsText* bt, int beats) {
+	if (beats == bt->beats) {
+		return false;
+	}
+	bt->text[1] = '0' + beats / 100;
+	put_two_digits(&bt->text[2], beats % 100);
+	bt->beats = beats;
+	return true;
+}
+
+// ---------- Weekday names ------------------------------
+
+void time_format_set_locale(const char* locale) {
+	locale_names = &LOCALES[0];
+	if (locale == NULL) {
+		return;
+	}
+	for (unsigned i = 0; i < ARRAY_LENGTH(LOCALES); i++) {
+		if (strncmp(locale, LOCALES[i].language, 2) == 0) {
+			locale_names = &LOCALES[i];
+			return;
+		}
+	}
+}
+
+const char* weekday_name(int wday) {
+	return locale_names->weekdays[wday % 7];
+}
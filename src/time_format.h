@@ -0,0 +1,46 @@
+/*
+Date and time text for the tick path, without strftime or snprintf.
+
+Each text keeps the fields it last wrote, so an update only writes the
+digits that changed and says whether anything did.  Digits come from a
+table of "00".."99" and weekday names from a per-locale table.
+*/
+
+#ifndef TIME_FORMAT_H
+#define TIME_FORMAT_H
+
+#include <pebble.h>
+
+typedef struct {
+	char text[6];   // "12:34", "9:05"
+	int8_t hour;    // Last written, -1 forces a full rewrite
+	int8_t minute;
+	bool is_24h;
+} TimeText;
+
+typedef struct {
+	char text[11];  // "2013-10-02"
+	int16_t year;
+	int8_t month;
+	int8_t mday;
+} DateText;
+
+typedef struct {
+	char text[5];   // "@042"
+	int16_t beats;
+} BeatsText;
+
+void time_text_reset(TimeText* tt);
+bool time_text_update(TimeText* tt, const struct tm* t, bool is_24h);
+
+void date_text_reset(DateText* dt);
+bool date_text_update(DateText* dt, const struct tm* t);
+
+void beats_text_reset(BeatsText* bt);
+bool beats_text_update(BeatsText* bt, int beats);
+
+// Full weekday name for the watch's language, English if we don't have it.
+void time_format_set_locale(const char* locale);
+const char* weekday_name(int wday);
+
+#endif // TIME_FORMAT_H
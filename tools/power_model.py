@@ -0,0 +1,224 @@
+#!/usr/bin/env python3
+"""
+Estimate the daily battery cost of a watchface configuration from the
+event trace written by the host simulation (build/host/gtt_sim -t FILE).
+
+Each trace is one configuration.  Give several to compare them:
+
+    tools/power_model.py --platform aplite default.trace novibe.trace
+
+The cost of each kind of work (a wakeup, a redrawn pixel, a millisecond
+of vibe, an AppMessage byte...) comes from a per-platform coefficient
+table.  The numbers below are starting estimates.  To calibrate them for
+a platform, run the face on a watch for a few days per configuration,
+note the battery used per day, and fit the same traces against it:
+
+    tools/power_model.py --platform basalt --calibrate \\
+        default.trace=14.5 nobeats.trace=13.8 > basalt.json
+    tools/power_model.py --coeffs basalt.json default.trace nobeats.trace
+
+Calibration fits the idle current and one scale factor for all the event
+costs (just the idle current when there's a single measurement).
+"""
+
+import argparse
+import json
+import os
+import sys
+
+# Costs in microamp-hours (uAh), idle in microamps (uA), battery in mAh.
+PLATFORMS = {
+    "aplite": {
+        "battery_mah": 130,
+        "idle_ua": 600,
+        "wakeup_uah": 0.020,
+        "frame_uah": 0.030,
+        "pixel_uah": 1.2e-6,
+        "vibe_ms_uah": 0.025,
+        "message_uah": 0.50,
+        "message_byte_uah": 0.002,
+        "bluetooth_uah": 0.30,
+    },
+    "basalt": {
+        "battery_mah": 150,
+        "idle_ua": 550,
+        "wakeup_uah": 0.015,
+        "frame_uah": 0.050,
+        "pixel_uah": 2.0e-6,
+        "vibe_ms_uah": 0.025,
+        "message_uah": 0.40,
+        "message_byte_uah": 0.0015,
+        "bluetooth_uah": 0.25,
+    },
+}
+
+WAKEUP_EVENTS = ("tick", "timer", "bluetooth", "battery", "inbox", "window", "launch")
+
+# (label, count in the trace summary, coefficient)
+ACTIVITY = (
+    ("wakeups", "wakeups", "wakeup_uah"),
+    ("frames", "frames", "frame_uah"),
+    ("pixels", "pixels", "pixel_uah"),
+    ("vibe ms", "vibe_ms", "vibe_ms_uah"),
+    ("messages", "messages", "message_uah"),
+    ("msg bytes", "message_bytes", "message_byte_uah"),
+    ("bluetooth", "bluetooth", "bluetooth_uah"),
+)
+
+
+def read_trace(path):
+    """Add up a trace into per-day counts."""
+    totals = dict.fromkeys(("wakeups", "frames", "pixels", "vibe_ms", "messages",
+                            "message_bytes", "bluetooth"), 0)
+    span = None
+    first = last = None
+
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith("#"):
+                fields = line[1:].strip().split(",")
+                if fields[0] == "span_ms":
+                    span = (int(fields[2]) - int(fields[1])) / 1000.0
+                continue
+
+            ms, event, value = line.split(",")
+            ms = int(ms)
+            value = int(value)
+            first = ms if first is None else first
+            last = ms
+
+            if event in WAKEUP_EVENTS:
+                totals["wakeups"] += 1
+            if event == "frame":
+                totals["frames"] += 1
+                totals["pixels"] += value
+            elif event == "vibe":
+                totals["vibe_ms"] += value
+            elif event in ("inbox", "outbox"):
+                totals["messages"] += 1
+                totals["message_bytes"] += value
+            elif event == "bluetooth":
+                totals["bluetooth"] += 1
+
+    if span is None:
+        span = ((last or 0) - (first or 0)) / 1000.0
+    days = span / 86400.0
+    if days <= 0:
+        sys.exit("%s: trace covers no time" % path)
+
+    return {k: v / days for k, v in totals.items()}, days
+
+
+def estimate(per_day, coeffs):
+    """uAh per day for idle and each kind of activity."""
+    parts = {"idle": coeffs["idle_ua"] * 24}
+    for label, count, coeff in ACTIVITY:
+        parts[label] = per_day[count] * coeffs[coeff] * coeffs.get("activity_scale", 1.0)
+    return parts
+
+
+def activity_uah(per_day, coeffs):
+    return sum(per_day[count] * coeffs[coeff] for _, count, coeff in ACTIVITY)
+
+
+def calibrate(runs, coeffs):
+    """Least squares fit of idle current and activity scale to measured %/day."""
+    # measured_uah = 24 * idle_ua + scale * activity_uah
+    rows = []
+    for per_day, percent in runs:
+        measured = percent / 100.0 * coeffs["battery_mah"] * 1000
+        rows.append((activity_uah(per_day, coeffs), measured))
+
+    if len(rows) == 1:
+        activity, measured = rows[0]
+        idle_ua, scale = (measured - activity) / 24, 1.0
+    else:
+        n = len(rows)
+        sx = sum(a for a, _ in rows)
+        sy = sum(m for _, m in rows)
+        sxx = sum(a * a for a, _ in rows)
+        sxy = sum(a * m for a, m in rows)
+        det = n * sxx - sx * sx
+        if det == 0:
+            sys.exit("calibrate: the traces have the same activity, can't separate idle from activity")
+        scale = (n * sxy - sx * sy) / det
+        idle_ua = (sy - scale * sx) / n / 24
+
+    if idle_ua < 0 or scale < 0:
+        print("warning: fit gave idle %.0f uA, scale %.2f; check the measurements" % (idle_ua, scale),
+              file=sys.stderr)
+
+    fitted = dict(coeffs)
+    fitted["idle_ua"] = round(idle_ua, 1)
+    fitted["activity_scale"] = round(scale, 3)
+    return fitted
+
+
+def report(configs, coeffs):
+    labels = ["idle"] + [label for label, _, _ in ACTIVITY]
+    name_w = max(len("config"), max(len(name) for name, _, _ in configs))
+
+    print("uAh per day by activity (%s mAh battery)" % coeffs["battery_mah"])
+    print("%-*s" % (name_w, "config") + "".join("%11s" % l for l in labels) +
+          "%11s%9s%8s" % ("total", "%/day", "days"))
+
+    base = None
+    for name, per_day, days in configs:
+        parts = estimate(per_day, coeffs)
+        total = sum(parts.values())
+        percent = total / (coeffs["battery_mah"] * 1000) * 100
+        line = "%-*s" % (name_w, name) + "".join("%11.1f" % parts[l] for l in labels)
+        line += "%11.1f%9.2f%8.1f" % (total, percent, 100 / percent)
+        if base is None:
+            base = total
+        elif base > 0:
+            line += "  %+.1f%%" % ((total - base) / base * 100)
+        print(line)
+
+    print()
+    print("Counts per day")
+    counts = [count for _, count, _ in ACTIVITY]
+    print("%-*s" % (name_w, "config") + "".join("%14s" % c for c in counts))
+    for name, per_day, days in configs:
+        print("%-*s" % (name_w, name) + "".join("%14.0f" % per_day[c] for c in counts))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("traces", nargs="+", metavar="TRACE[=PERCENT_PER_DAY]",
+                        help="trace files; with --calibrate, each with its measured battery %%/day")
+    parser.add_argument("--platform", choices=sorted(PLATFORMS), default="aplite")
+    parser.add_argument("--coeffs", help="JSON coefficients, e.g. from --calibrate")
+    parser.add_argument("--calibrate", action="store_true",
+                        help="fit the coefficients to measured drain and print them as JSON")
+    args = parser.parse_args()
+
+    coeffs = dict(PLATFORMS[args.platform])
+    if args.coeffs:
+        with open(args.coeffs) as f:
+            coeffs.update(json.load(f))
+
+    if args.calibrate:
+        runs = []
+        for arg in args.traces:
+            path, sep, percent = arg.rpartition("=")
+            if not sep:
+                sys.exit("calibrate: give each trace as TRACE=PERCENT_PER_DAY")
+            runs.append((read_trace(path)[0], float(percent)))
+        json.dump(calibrate(runs, coeffs), sys.stdout, indent=2, sort_keys=True)
+        print()
+        return
+
+    configs = []
+    for path in args.traces:
+        per_day, days = read_trace(path)
+        name = os.path.splitext(os.path.basename(path))[0]
+        configs.append((name, per_day, days))
+    report(configs, coeffs)
+
+
+if __name__ == "__main__":
+    main()